@@ -536,6 +536,12 @@ struct slurmdb_assoc_usage {
 	double grp_used_wall;   /* group count of time used in running jobs */
 	double fs_factor;	/* Fairshare factor. Not used by all algorithms
 				 * (DON'T PACK for state file) */
+	slurmdb_assoc_rec_t **fs_children; /* (FAIR_TREE) children_list
+					    * sorted by level_fs, NULL
+					    * terminated (DON'T PACK) */
+	bool fs_dirty;		/* (FAIR_TREE) usage or shares changed under
+				 * this association since fs_children was
+				 * sorted (DON'T PACK) */
 	uint32_t level_shares;  /* number of shares on this level of
 				 * the tree (DON'T PACK for state file) */
 
@@ -780,6 +786,8 @@ typedef struct {
 typedef struct {
 	List acct_limit_list; /* slurmdb_used_limits_t's (DON'T PACK
 			       * for state file) */
+	void *acct_limit_hash; /* xhash_t index of acct_limit_list by
+				* account (DON'T PACK for state file) */
 	List job_list; /* list of job pointers to submitted/running
 			  jobs (DON'T PACK) */
 	uint32_t grp_used_jobs;	/* count of active jobs (DON'T PACK
@@ -803,6 +811,8 @@ typedef struct {
 				      * PACK for state file)*/
 	List user_limit_list; /* slurmdb_used_limits_t's (DON'T PACK
 			       * for state file) */
+	void *user_limit_hash; /* xhash_t index of user_limit_list by
+				* uid (DON'T PACK for state file) */
 } slurmdb_qos_usage_t;
 
 typedef struct {
@@ -1075,7 +1075,14 @@ _load_cluster_jobs(slurm_msg_t *req_msg, job_info_msg_t **job_info_msg_pptr,
 
 	*job_info_msg_pptr = NULL;
 
-	if (slurm_send_recv_controller_msg(req_msg, &resp_msg, cluster) < 0)
+	if ((req_msg->msg_type == REQUEST_JOB_INFO) &&
+	    (((job_info_request_msg_t *) req_msg->data)->show_flags &
+	     SHOW_REPLICA)) {
+		if (slurm_send_recv_replica_msg(req_msg, &resp_msg,
+						cluster) < 0)
+			return SLURM_ERROR;
+	} else if (slurm_send_recv_controller_msg(req_msg, &resp_msg,
+						  cluster) < 0)
 		return SLURM_ERROR;
 
 	switch (resp_msg.msg_type) {
@@ -1312,6 +1319,25 @@ extern int slurm_job_batch_script(FILE *out, uint32_t jobid)
 extern int
 slurm_load_jobs (time_t update_time, job_info_msg_t **job_info_msg_pptr,
 		 uint16_t show_flags)
+{
+	return slurm_load_jobs_filter(update_time, job_info_msg_pptr,
+				      show_flags, NULL);
+}
+
+/*
+ * slurm_load_jobs_filter - equivalent to slurm_load_jobs() with only the jobs
+ *	matching the filter being packed and returned by slurmctld
+ * IN update_time - time of current configuration data
+ * IN/OUT job_info_msg_pptr - place to store a job configuration pointer
+ * IN show_flags -  job filtering option: 0, SHOW_ALL, SHOW_DETAIL or SHOW_LOCAL
+ * IN filter - jobs to return, NULL for all
+ * RET 0 or -1 on error
+ * NOTE: free the response using slurm_free_job_info_msg
+ */
+extern int slurm_load_jobs_filter(time_t update_time,
+				  job_info_msg_t **job_info_msg_pptr,
+				  uint16_t show_flags,
+				  job_info_filter_t *filter)
 {
 	slurm_msg_t req_msg;
 	job_info_request_msg_t req = {0};
@@ -1339,6 +1365,8 @@ slurm_load_jobs (time_t update_time, job_info_msg_t **job_info_msg_pptr,
 	slurm_msg_t_init(&req_msg);
 	req.last_update  = update_time;
 	req.show_flags   = show_flags;
+	if (filter)
+		req.filter = *filter;
 	req_msg.msg_type = REQUEST_JOB_INFO;
 	req_msg.data     = &req;
 
@@ -541,7 +541,13 @@ static int _load_cluster_nodes(slurm_msg_t *req_msg,
 
 	slurm_msg_t_init(&resp_msg);
 
-	if (slurm_send_recv_controller_msg(req_msg, &resp_msg, cluster) < 0)
+	if ((req_msg->msg_type == REQUEST_NODE_INFO) &&
+	    (show_flags & SHOW_REPLICA)) {
+		if (slurm_send_recv_replica_msg(req_msg, &resp_msg,
+						cluster) < 0)
+			return SLURM_ERROR;
+	} else if (slurm_send_recv_controller_msg(req_msg, &resp_msg,
+						  cluster) < 0)
 		return SLURM_ERROR;
 
 	switch (resp_msg.msg_type) {
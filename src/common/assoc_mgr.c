@@ -951,6 +951,7 @@ static int _post_assoc_list(void)
 	list_iterator_destroy(itr);
 
 	slurmdb_sort_hierarchical_assoc_list(assoc_mgr_assoc_list, true);
+	assoc_mgr_set_fs_dirty(NULL);
 
 	//END_TIMER2("load_associations");
 	return SLURM_SUCCESS;
@@ -3934,6 +3935,10 @@ extern int assoc_mgr_update_assocs(slurmdb_update_object_t *update, bool locked)
 		slurmdb_sort_hierarchical_assoc_list(
 			assoc_mgr_assoc_list, true);
 
+	/* Shares, usage or the tree itself may have changed */
+	if (setup_children)
+		assoc_mgr_set_fs_dirty(NULL);
+
 	if (!locked)
 		assoc_mgr_unlock(&locks);
 
@@ -4929,6 +4934,7 @@ static void _reset_children_usages(List children_list)
 		assoc->usage->grp_used_wall = 0.0;
 		for (i=0; i<assoc->usage->tres_cnt; i++)
 			assoc->usage->usage_tres_raw[i] = 0;
+		assoc->usage->fs_dirty = true;
 
 		if (assoc->user)
 			continue;
@@ -5055,6 +5061,7 @@ extern void assoc_mgr_remove_assoc_usage(slurmdb_assoc_rec_t *assoc)
 		assoc->usage->grp_used_wall -= old_grp_used_wall;
 		assoc = assoc->usage->parent_assoc_ptr;
 	}
+	assoc_mgr_set_fs_dirty(sav_assoc);
 	if (sav_assoc->user)
 		return;
 /*
@@ -5063,6 +5070,25 @@ extern void assoc_mgr_remove_assoc_usage(slurmdb_assoc_rec_t *assoc)
 	_reset_children_usages(sav_assoc->usage->children_list);
 }
 
+extern void assoc_mgr_set_fs_dirty(slurmdb_assoc_rec_t *assoc)
+{
+	ListIterator itr;
+
+	if (assoc) {
+		for ( ; assoc; assoc = assoc->usage->parent_assoc_ptr)
+			assoc->usage->fs_dirty = true;
+		return;
+	}
+
+	if (!assoc_mgr_assoc_list)
+		return;
+
+	itr = list_iterator_create(assoc_mgr_assoc_list);
+	while ((assoc = list_next(itr)))
+		assoc->usage->fs_dirty = true;
+	list_iterator_destroy(itr);
+}
+
 extern void assoc_mgr_remove_qos_usage(slurmdb_qos_rec_t *qos)
 {
 	int i;
@@ -5453,6 +5479,7 @@ extern int load_assoc_usage(char *state_save_location)
 
 		xfree(tmp_str);
 	}
+	assoc_mgr_set_fs_dirty(NULL);
 	assoc_mgr_unlock(&locks);
 
 	free_buf(buffer);
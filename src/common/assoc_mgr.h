@@ -383,6 +383,15 @@ extern void assoc_mgr_clear_used_info(void);
  */
 extern void assoc_mgr_remove_assoc_usage(slurmdb_assoc_rec_t *assoc);
 
+/*
+ * Note that the usage_raw or shares of an association changed so the
+ * fairshare of the levels under it and under each of its parents must be
+ * recalculated, the other levels are left as they are.
+ * IN:  slurmdb_assoc_rec_t *assoc, NULL for every association
+ * note: call with assoc_mgr_lock(WRITE_LOCK) on assocs
+ */
+extern void assoc_mgr_set_fs_dirty(slurmdb_assoc_rec_t *assoc);
+
 /*
  * Remove the QOS's accumulated usage
  * IN:  slurmdb_qos_rec_t *qos
@@ -3469,12 +3469,78 @@ static void _validate_gres_node_cpus(gres_node_state_t *node_gres_ptr,
 	}
 }
 
+/*
+ * Copy one node's CPUs out of a multi-node cpu_bitmap so they can be compared
+ *	with the node's topo_cpus_bitmap using whole bitmap operations
+ */
+static bitstr_t *_cpu_window_get(bitstr_t *cpu_bitmap, int cpu_start_bit,
+				 int cpu_cnt)
+{
+	bitstr_t *cpu_window = bit_alloc(cpu_cnt);
+	int i;
+
+	for (i = 0; i < cpu_cnt; i++) {
+		if (bit_test(cpu_bitmap, cpu_start_bit + i))
+			bit_set(cpu_window, i);
+	}
+	return cpu_window;
+}
+
+/* Clear the node's CPUs in cpu_bitmap which are not set in cpu_window */
+static void _cpu_window_clear(bitstr_t *cpu_bitmap, int cpu_start_bit,
+			      bitstr_t *cpu_window)
+{
+	int i, cpu_cnt = bit_size(cpu_window);
+
+	for (i = 0; i < cpu_cnt; i++) {
+		if (!bit_test(cpu_window, i))
+			bit_clear(cpu_bitmap, cpu_start_bit + i);
+	}
+}
+
+/*
+ * Fill node_gres_inx, indexed like gres_context and zeroed by the caller, with
+ *	the node's GRES state for each plugin so that each job GRES is matched
+ *	without a list scan
+ */
+static void _node_gres_index(List node_gres_list, gres_state_t **node_gres_inx)
+{
+	ListIterator node_gres_iter;
+	gres_state_t *node_gres_ptr;
+	int i;
+
+	node_gres_iter = list_iterator_create(node_gres_list);
+	while ((node_gres_ptr = (gres_state_t *) list_next(node_gres_iter))) {
+		for (i = 0; i < gres_context_cnt; i++) {
+			if (node_gres_ptr->plugin_id ==
+			    gres_context[i].plugin_id) {
+				if (!node_gres_inx[i])
+					node_gres_inx[i] = node_gres_ptr;
+				break;
+			}
+		}
+	}
+	list_iterator_destroy(node_gres_iter);
+}
+
+/* Return the gres_context index of a plugin_id or -1 if not configured */
+static int _context_inx(uint32_t plugin_id)
+{
+	int i;
+
+	for (i = 0; i < gres_context_cnt; i++) {
+		if (gres_context[i].plugin_id == plugin_id)
+			return i;
+	}
+	return -1;
+}
+
 static void	_job_core_filter(void *job_gres_data, void *node_gres_data,
 				 bool use_total_gres, bitstr_t *cpu_bitmap,
 				 int cpu_start_bit, int cpu_end_bit,
 				 char *gres_name, char *node_name)
 {
-	int i, j, cpus_ctld;
+	int i, cpus_ctld;
 	gres_job_state_t  *job_gres_ptr  = (gres_job_state_t *)  job_gres_data;
 	gres_node_state_t *node_gres_ptr = (gres_node_state_t *) node_gres_data;
 	bitstr_t *avail_cpu_bitmap = NULL;
@@ -3484,8 +3550,9 @@ static void	_job_core_filter(void *job_gres_data, void *node_gres_data,
 		return;
 
 	/* Determine which specific CPUs can be used */
-	avail_cpu_bitmap = bit_copy(cpu_bitmap);
-	bit_nclear(avail_cpu_bitmap, cpu_start_bit, cpu_end_bit);
+	cpus_ctld = cpu_end_bit - cpu_start_bit + 1;
+	_validate_gres_node_cpus(node_gres_ptr, cpus_ctld, node_name);
+	avail_cpu_bitmap = bit_alloc(cpus_ctld);
 	for (i = 0; i < node_gres_ptr->topo_cnt; i++) {
 		if (node_gres_ptr->topo_gres_cnt_avail[i] == 0)
 			continue;
@@ -3502,16 +3569,9 @@ static void	_job_core_filter(void *job_gres_data, void *node_gres_data,
 			FREE_NULL_BITMAP(avail_cpu_bitmap);	/* No filter */
 			return;
 		}
-		cpus_ctld = cpu_end_bit - cpu_start_bit + 1;
-		_validate_gres_node_cpus(node_gres_ptr, cpus_ctld, node_name);
-		cpus_ctld = bit_size(node_gres_ptr->topo_cpus_bitmap[i]);
-		for (j = 0; j < cpus_ctld; j++) {
-			if (bit_test(node_gres_ptr->topo_cpus_bitmap[i], j)) {
-				bit_set(avail_cpu_bitmap, cpu_start_bit + j);
-			}
-		}
+		bit_or(avail_cpu_bitmap, node_gres_ptr->topo_cpus_bitmap[i]);
 	}
-	bit_and(cpu_bitmap, avail_cpu_bitmap);
+	_cpu_window_clear(cpu_bitmap, cpu_start_bit, avail_cpu_bitmap);
 	FREE_NULL_BITMAP(avail_cpu_bitmap);
 }
 
@@ -3520,7 +3580,7 @@ static uint32_t _job_test(void *job_gres_data, void *node_gres_data,
 			  int cpu_start_bit, int cpu_end_bit, bool *topo_set,
 			  uint32_t job_id, char *node_name, char *gres_name)
 {
-	int i, j, cpu_size, cpus_ctld, top_inx;
+	int i, j, cpus_ctld, top_inx;
 	uint64_t gres_avail = 0, gres_total;
 	gres_job_state_t  *job_gres_ptr  = (gres_job_state_t *)  job_gres_data;
 	gres_node_state_t *node_gres_ptr = (gres_node_state_t *) node_gres_data;
@@ -3529,6 +3589,7 @@ static uint32_t _job_test(void *job_gres_data, void *node_gres_data,
 	uint32_t cpu_cnt = 0;
 	bitstr_t *alloc_cpu_bitmap = NULL;
 	bitstr_t *avail_cpu_bitmap = NULL;
+	bitstr_t *topo_cpus;
 
 	if (node_gres_ptr->no_consume)
 		use_total_gres = true;
@@ -3546,6 +3607,9 @@ static uint32_t _job_test(void *job_gres_data, void *node_gres_data,
 			}
 			_validate_gres_node_cpus(node_gres_ptr, cpus_ctld,
 						 node_name);
+			avail_cpu_bitmap = _cpu_window_get(cpu_bitmap,
+							   cpu_start_bit,
+							   cpus_ctld);
 		}
 		for (i = 0; i < node_gres_ptr->topo_cnt; i++) {
 			if (job_gres_ptr->type_model &&
@@ -3553,33 +3617,19 @@ static uint32_t _job_test(void *job_gres_data, void *node_gres_data,
 			     xstrcmp(node_gres_ptr->topo_model[i],
 				     job_gres_ptr->type_model)))
 				continue;
-			if (!node_gres_ptr->topo_cpus_bitmap[i]) {
-				gres_avail += node_gres_ptr->
-					      topo_gres_cnt_avail[i];
-				if (!use_total_gres) {
-					gres_avail -= node_gres_ptr->
-						      topo_gres_cnt_alloc[i];
-				}
-				continue;
-			}
-			cpus_ctld = bit_size(node_gres_ptr->
-					     topo_cpus_bitmap[i]);
-			for (j = 0; j < cpus_ctld; j++) {
-				if (cpu_bitmap &&
-				    !bit_test(cpu_bitmap, cpu_start_bit+j))
-					continue;
-				if (!bit_test(node_gres_ptr->
-					      topo_cpus_bitmap[i], j))
-					continue; /* not avail for this gres */
-				gres_avail += node_gres_ptr->
-					      topo_gres_cnt_avail[i];
-				if (!use_total_gres) {
-					gres_avail -= node_gres_ptr->
-						      topo_gres_cnt_alloc[i];
-				}
-				break;
+			topo_cpus = node_gres_ptr->topo_cpus_bitmap[i];
+			if (topo_cpus &&
+			    (avail_cpu_bitmap ?
+			     !bit_overlap(avail_cpu_bitmap, topo_cpus) :
+			     (bit_ffs(topo_cpus) == -1)))
+				continue;	/* not avail for this gres */
+			gres_avail += node_gres_ptr->topo_gres_cnt_avail[i];
+			if (!use_total_gres) {
+				gres_avail -= node_gres_ptr->
+					      topo_gres_cnt_alloc[i];
 			}
 		}
+		FREE_NULL_BITMAP(avail_cpu_bitmap);
 		if (job_gres_ptr->gres_cnt_alloc > gres_avail)
 			return (uint32_t) 0;	/* insufficient, gres to use */
 		return NO_VAL;
@@ -3610,13 +3660,12 @@ static uint32_t _job_test(void *job_gres_data, void *node_gres_data,
 			}
 		}
 
-		alloc_cpu_bitmap = bit_alloc(cpus_ctld);
 		if (cpu_bitmap) {
-			for (j = 0; j < cpus_ctld; j++) {
-				if (bit_test(cpu_bitmap, cpu_start_bit+j))
-					bit_set(alloc_cpu_bitmap, j);
-			}
+			alloc_cpu_bitmap = _cpu_window_get(cpu_bitmap,
+							   cpu_start_bit,
+							   cpus_ctld);
 		} else {
+			alloc_cpu_bitmap = bit_alloc(cpus_ctld);
 			bit_nset(alloc_cpu_bitmap, 0, cpus_ctld - 1);
 		}
 
@@ -3639,15 +3688,13 @@ static uint32_t _job_test(void *job_gres_data, void *node_gres_data,
 				cpus_avail[i] = cpu_end_bit - cpu_start_bit + 1;
 				continue;
 			}
-			cpu_size = bit_size(node_gres_ptr->topo_cpus_bitmap[i]);
-			for (j = 0; j < cpu_size; j++) {
-				if (cpu_bitmap &&
-				    !bit_test(cpu_bitmap, cpu_start_bit+j))
-					continue;
-				if (bit_test(node_gres_ptr->
-					     topo_cpus_bitmap[i], j)) {
-					cpus_avail[i]++;
-				}
+			if (cpu_bitmap) {
+				cpus_avail[i] = bit_overlap(avail_cpu_bitmap,
+							    node_gres_ptr->
+							    topo_cpus_bitmap[i]);
+			} else {
+				cpus_avail[i] = bit_set_count(node_gres_ptr->
+							topo_cpus_bitmap[i]);
 			}
 		}
 
@@ -3714,10 +3761,8 @@ static uint32_t _job_test(void *job_gres_data, void *node_gres_data,
 		}
 		if (cpu_bitmap && (cpu_cnt > 0)) {
 			*topo_set = true;
-			for (i = 0; i < cpus_ctld; i++) {
-				if (!bit_test(alloc_cpu_bitmap, i))
-					bit_clear(cpu_bitmap, cpu_start_bit+i);
-			}
+			_cpu_window_clear(cpu_bitmap, cpu_start_bit,
+					  alloc_cpu_bitmap);
 		}
 		FREE_NULL_BITMAP(alloc_cpu_bitmap);
 		FREE_NULL_BITMAP(avail_cpu_bitmap);
@@ -3768,8 +3813,8 @@ extern void gres_plugin_job_core_filter(List job_gres_list, List node_gres_list,
 					char *node_name)
 {
 	int i;
-	ListIterator  job_gres_iter, node_gres_iter;
-	gres_state_t *job_gres_ptr, *node_gres_ptr;
+	ListIterator  job_gres_iter;
+	gres_state_t *job_gres_ptr, *node_gres_ptr, **node_gres_inx;
 
 	if ((job_gres_list == NULL) || (cpu_bitmap == NULL))
 		return;
@@ -3781,34 +3826,26 @@ extern void gres_plugin_job_core_filter(List job_gres_list, List node_gres_list,
 	(void) gres_plugin_init();
 
 	slurm_mutex_lock(&gres_context_lock);
+	node_gres_inx = xmalloc(sizeof(gres_state_t *) * gres_context_cnt);
+	_node_gres_index(node_gres_list, node_gres_inx);
 	job_gres_iter = list_iterator_create(job_gres_list);
 	while ((job_gres_ptr = (gres_state_t *) list_next(job_gres_iter))) {
-		node_gres_iter = list_iterator_create(node_gres_list);
-		while ((node_gres_ptr = (gres_state_t *)
-				list_next(node_gres_iter))) {
-			if (job_gres_ptr->plugin_id == node_gres_ptr->plugin_id)
-				break;
-		}
-		list_iterator_destroy(node_gres_iter);
+		i = _context_inx(job_gres_ptr->plugin_id);
+		node_gres_ptr = (i < 0) ? NULL : node_gres_inx[i];
 		if (node_gres_ptr == NULL) {
 			/* node lack resources required by the job */
 			bit_nclear(cpu_bitmap, cpu_start_bit, cpu_end_bit);
 			break;
 		}
 
-		for (i = 0; i < gres_context_cnt; i++) {
-			if (job_gres_ptr->plugin_id !=
-			    gres_context[i].plugin_id)
-				continue;
-			_job_core_filter(job_gres_ptr->gres_data,
-					 node_gres_ptr->gres_data,
-					 use_total_gres, cpu_bitmap,
-					 cpu_start_bit, cpu_end_bit,
-					 gres_context[i].gres_name, node_name);
-			break;
-		}
+		_job_core_filter(job_gres_ptr->gres_data,
+				 node_gres_ptr->gres_data,
+				 use_total_gres, cpu_bitmap,
+				 cpu_start_bit, cpu_end_bit,
+				 gres_context[i].gres_name, node_name);
 	}
 	list_iterator_destroy(job_gres_iter);
+	xfree(node_gres_inx);
 	slurm_mutex_unlock(&gres_context_lock);
 
 	return;
@@ -3835,8 +3872,8 @@ extern uint32_t gres_plugin_job_test(List job_gres_list, List node_gres_list,
 {
 	int i;
 	uint32_t cpu_cnt, tmp_cnt;
-	ListIterator job_gres_iter,  node_gres_iter;
-	gres_state_t *job_gres_ptr, *node_gres_ptr;
+	ListIterator job_gres_iter;
+	gres_state_t *job_gres_ptr, *node_gres_ptr, **node_gres_inx;
 	bool topo_set = false;
 
 	if (job_gres_list == NULL)
@@ -3848,43 +3885,35 @@ extern uint32_t gres_plugin_job_test(List job_gres_list, List node_gres_list,
 	(void) gres_plugin_init();
 
 	slurm_mutex_lock(&gres_context_lock);
+	node_gres_inx = xmalloc(sizeof(gres_state_t *) * gres_context_cnt);
+	_node_gres_index(node_gres_list, node_gres_inx);
 	job_gres_iter = list_iterator_create(job_gres_list);
 	while ((job_gres_ptr = (gres_state_t *) list_next(job_gres_iter))) {
-		node_gres_iter = list_iterator_create(node_gres_list);
-		while ((node_gres_ptr = (gres_state_t *)
-				list_next(node_gres_iter))) {
-			if (job_gres_ptr->plugin_id == node_gres_ptr->plugin_id)
-				break;
-		}
-		list_iterator_destroy(node_gres_iter);
+		i = _context_inx(job_gres_ptr->plugin_id);
+		node_gres_ptr = (i < 0) ? NULL : node_gres_inx[i];
 		if (node_gres_ptr == NULL) {
 			/* node lack resources required by the job */
 			cpu_cnt = 0;
 			break;
 		}
 
-		for (i=0; i<gres_context_cnt; i++) {
-			if (job_gres_ptr->plugin_id !=
-			    gres_context[i].plugin_id)
-				continue;
-			tmp_cnt = _job_test(job_gres_ptr->gres_data,
-					    node_gres_ptr->gres_data,
-					    use_total_gres, cpu_bitmap,
-					    cpu_start_bit, cpu_end_bit,
-					    &topo_set, job_id, node_name,
-					    gres_context[i].gres_name);
-			if (tmp_cnt != NO_VAL) {
-				if (cpu_cnt == NO_VAL)
-					cpu_cnt = tmp_cnt;
-				else
-					cpu_cnt = MIN(tmp_cnt, cpu_cnt);
-			}
-			break;
+		tmp_cnt = _job_test(job_gres_ptr->gres_data,
+				    node_gres_ptr->gres_data,
+				    use_total_gres, cpu_bitmap,
+				    cpu_start_bit, cpu_end_bit,
+				    &topo_set, job_id, node_name,
+				    gres_context[i].gres_name);
+		if (tmp_cnt != NO_VAL) {
+			if (cpu_cnt == NO_VAL)
+				cpu_cnt = tmp_cnt;
+			else
+				cpu_cnt = MIN(tmp_cnt, cpu_cnt);
 		}
 		if (cpu_cnt == 0)
 			break;
 	}
 	list_iterator_destroy(job_gres_iter);
+	xfree(node_gres_inx);
 	slurm_mutex_unlock(&gres_context_lock);
 
 	return cpu_cnt;
@@ -3944,6 +3973,65 @@ static bool _cores_on_gres(bitstr_t *core_bitmap, bitstr_t *alloc_core_bitmap,
 	return false;
 }
 
+/*
+ * Build a bitmap of the GRES indexes for which _cores_on_gres() with no
+ *	alloc_core_bitmap would return true, walking each topology entry once
+ *	rather than each topology entry for each GRES index
+ * RET bitmap to be freed or NULL if topology GRES bitmap sizes do not match
+ *	the node's GRES count
+ */
+static bitstr_t *_gres_on_cores(bitstr_t *core_bitmap,
+				gres_node_state_t *node_gres_ptr,
+				gres_job_state_t *job_gres_ptr)
+{
+	bitstr_t *avail_gres, *done_gres, *topo_gres, *topo_cpus;
+	int i;
+
+	if (node_gres_ptr->gres_cnt_avail == 0)
+		return NULL;
+	avail_gres = bit_alloc(node_gres_ptr->gres_cnt_avail);
+	if ((core_bitmap == NULL) || (node_gres_ptr->topo_cnt == 0)) {
+		bit_nset(avail_gres, 0, node_gres_ptr->gres_cnt_avail - 1);
+		return avail_gres;
+	}
+	for (i = 0; i < node_gres_ptr->topo_cnt; i++) {
+		topo_gres = node_gres_ptr->topo_gres_bitmap[i];
+		if (topo_gres && (bit_size(topo_gres) !=
+				  node_gres_ptr->gres_cnt_avail)) {
+			FREE_NULL_BITMAP(avail_gres);
+			return NULL;
+		}
+	}
+
+	/* GRES decided by an earlier topology entry, as the loop would be */
+	done_gres = bit_alloc(node_gres_ptr->gres_cnt_avail);
+	for (i = 0; i < node_gres_ptr->topo_cnt; i++) {
+		topo_gres = node_gres_ptr->topo_gres_bitmap[i];
+		if (!topo_gres)
+			continue;
+		if (job_gres_ptr->type_model &&
+		    (!node_gres_ptr->topo_model[i] ||
+		     xstrcmp(job_gres_ptr->type_model,
+			     node_gres_ptr->topo_model[i])))
+			continue;
+		topo_cpus = node_gres_ptr->topo_cpus_bitmap[i];
+		if (!topo_cpus ||
+		    ((bit_size(topo_cpus) == bit_size(core_bitmap)) &&
+		     bit_overlap(topo_cpus, core_bitmap))) {
+			topo_gres = bit_copy(topo_gres);
+			bit_and_not(topo_gres, done_gres);
+			bit_or(avail_gres, topo_gres);
+			FREE_NULL_BITMAP(topo_gres);
+			bit_or(done_gres, node_gres_ptr->topo_gres_bitmap[i]);
+		} else if (bit_size(topo_cpus) != bit_size(core_bitmap)) {
+			bit_or(done_gres, topo_gres);
+		}
+	}
+	FREE_NULL_BITMAP(done_gres);
+
+	return avail_gres;
+}
+
 /* Clear any vestigial job gres state. This may be needed on job requeue. */
 extern void gres_plugin_job_clear(List job_gres_list)
 {
@@ -3989,7 +4077,7 @@ static int _job_alloc(void *job_gres_data, void *node_gres_data,
 	gres_job_state_t  *job_gres_ptr  = (gres_job_state_t *)  job_gres_data;
 	gres_node_state_t *node_gres_ptr = (gres_node_state_t *) node_gres_data;
 	bool type_array_updated = false;
-	bitstr_t *alloc_core_bitmap = NULL;
+	bitstr_t *alloc_core_bitmap = NULL, *avail_gres = NULL;
 
 	/*
 	 * Validate data structures. Either job_gres_data->node_cnt and
@@ -4099,10 +4187,14 @@ static int _job_alloc(void *job_gres_data, void *node_gres_data,
 		}
 		if (core_bitmap)
 			alloc_core_bitmap = bit_alloc(bit_size(core_bitmap));
+		avail_gres = _gres_on_cores(core_bitmap, node_gres_ptr,
+					    job_gres_ptr);
 		/* Pass 1: Allocate GRES overlapping all allocated cores */
 		for (i=0; i<node_gres_ptr->gres_cnt_avail && gres_cnt>0; i++) {
 			if (bit_test(node_gres_ptr->gres_bit_alloc, i))
 				continue;
+			if (avail_gres && !bit_test(avail_gres, i))
+				continue;
 			if (!_cores_on_gres(core_bitmap, alloc_core_bitmap,
 					    node_gres_ptr, i, job_gres_ptr))
 				continue;
@@ -4116,14 +4208,20 @@ static int _job_alloc(void *job_gres_data, void *node_gres_data,
 		for (i=0; i<node_gres_ptr->gres_cnt_avail && gres_cnt>0; i++) {
 			if (bit_test(node_gres_ptr->gres_bit_alloc, i))
 				continue;
-			if (!_cores_on_gres(core_bitmap, NULL, node_gres_ptr, i,
-					    job_gres_ptr))
+			if (avail_gres) {
+				if (!bit_test(avail_gres, i))
+					continue;
+			} else if (!_cores_on_gres(core_bitmap, NULL,
+						   node_gres_ptr, i,
+						   job_gres_ptr)) {
 				continue;
+			}
 			bit_set(node_gres_ptr->gres_bit_alloc, i);
 			bit_set(job_gres_ptr->gres_bit_alloc[node_offset], i);
 			node_gres_ptr->gres_cnt_alloc++;
 			gres_cnt--;
 		}
+		FREE_NULL_BITMAP(avail_gres);
 		if (gres_cnt)
 			verbose("Gres topology sub-optimal for job %u", job_id);
 		/* Pass 3: Allocate any available GRES */
@@ -4261,8 +4359,8 @@ extern int gres_plugin_job_alloc(List job_gres_list, List node_gres_list,
 				 char *node_name, bitstr_t *core_bitmap)
 {
 	int i, rc, rc2;
-	ListIterator job_gres_iter,  node_gres_iter;
-	gres_state_t *job_gres_ptr, *node_gres_ptr;
+	ListIterator job_gres_iter;
+	gres_state_t *job_gres_ptr, *node_gres_ptr, **node_gres_inx;
 
 	if (job_gres_list == NULL)
 		return SLURM_SUCCESS;
@@ -4275,14 +4373,12 @@ extern int gres_plugin_job_alloc(List job_gres_list, List node_gres_list,
 	rc = gres_plugin_init();
 
 	slurm_mutex_lock(&gres_context_lock);
+	node_gres_inx = xmalloc(sizeof(gres_state_t *) * gres_context_cnt);
+	_node_gres_index(node_gres_list, node_gres_inx);
 	job_gres_iter = list_iterator_create(job_gres_list);
 	while ((job_gres_ptr = (gres_state_t *) list_next(job_gres_iter))) {
-		for (i = 0; i < gres_context_cnt; i++) {
-			if (job_gres_ptr->plugin_id ==
-			    gres_context[i].plugin_id)
-				break;
-		}
-		if (i >= gres_context_cnt) {
+		i = _context_inx(job_gres_ptr->plugin_id);
+		if (i < 0) {
 			error("gres_plugin_job_alloc: no plugin configured "
 			      "for data type %u for job %u and node %s",
 			      job_gres_ptr->plugin_id, job_id, node_name);
@@ -4290,13 +4386,7 @@ extern int gres_plugin_job_alloc(List job_gres_list, List node_gres_list,
 			continue;
 		}
 
-		node_gres_iter = list_iterator_create(node_gres_list);
-		while ((node_gres_ptr = (gres_state_t *)
-				list_next(node_gres_iter))) {
-			if (job_gres_ptr->plugin_id == node_gres_ptr->plugin_id)
-				break;
-		}
-		list_iterator_destroy(node_gres_iter);
+		node_gres_ptr = node_gres_inx[i];
 		if (node_gres_ptr == NULL) {
 			error("gres_plugin_job_alloc: job %u allocated gres/%s "
 			      "on node %s lacking that gres",
@@ -4313,6 +4403,7 @@ extern int gres_plugin_job_alloc(List job_gres_list, List node_gres_list,
 			rc = rc2;
 	}
 	list_iterator_destroy(job_gres_iter);
+	xfree(node_gres_inx);
 	slurm_mutex_unlock(&gres_context_lock);
 
 	return rc;
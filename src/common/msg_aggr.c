@@ -49,14 +49,24 @@
 #include "src/common/slurm_auth.h"
 #include "src/common/slurm_route.h"
 #include "src/common/slurm_protocol_interface.h"
+#include "src/common/timers.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
 #include "src/slurmd/slurmd/slurmd.h"
 
+/*
+ * Lower bound of an adaptive collection window in milliseconds. At low
+ * message rates the window shrinks to this so messages are not delayed
+ * waiting for peers that are not going to arrive.
+ */
+#define ADAPT_WINDOW_MIN	1
+
 typedef struct {
 	pthread_mutex_t	aggr_mutex;
+	uint64_t        arrival_usec;	/* avg usec between msg arrivals */
 	pthread_cond_t	cond;
 	uint32_t        debug_flags;
+	struct timeval  last_arrival;	/* when the last msg was collected */
 	bool		max_msgs;
 	uint64_t        max_msg_cnt;
 	List            msg_aggr_list;
@@ -64,8 +74,14 @@ typedef struct {
 	pthread_mutex_t	mutex;
 	slurm_addr_t    node_addr;
 	bool            running;
+	uint64_t        send_usec;	/* avg usec to send a composite msg */
+	uint64_t        stat_comp_cnt;	/* composite msgs sent */
+	uint64_t        stat_msg_cnt;	/* msgs sent in composite msgs */
+	uint64_t        stat_wait_usec;	/* sum of usec spent in windows */
 	pthread_t       thread_id;
 	uint64_t        window;
+	uint64_t        window_max;	/* adaptive window upper bound,
+					 * 0 if the window is fixed */
 } msg_collection_type_t;
 
 typedef struct {
@@ -184,6 +200,52 @@ static int _send_to_next_collector(slurm_msg_t *msg)
 	return rc;
 }
 
+/*
+ * Fold a new sample into an exponentially weighted moving average, giving
+ * the new sample a weight of 1/8.
+ */
+static uint64_t _ewma(uint64_t avg, uint64_t sample)
+{
+	if (!avg)
+		return sample;
+	return ((avg * 7) + sample) / 8;
+}
+
+/*
+ * Compute the length in milliseconds of the next message collection window.
+ * With a fixed window this is just the configured WindowTime. Otherwise
+ * the window is sized to the time expected to fill a composite message at
+ * the observed arrival rate, but never shorter than the time it takes to
+ * send a composite message downstream, and bounded by WindowTimeMax.
+ * Called with msg_collection.mutex locked.
+ */
+static uint64_t _get_window(void)
+{
+	uint64_t window_usec, min_usec, max_usec;
+
+	if (!msg_collection.window_max)
+		return msg_collection.window;
+
+	min_usec = ADAPT_WINDOW_MIN * 1000;
+	max_usec = msg_collection.window_max * 1000;
+
+	/* No history yet, start from the configured window */
+	if (!msg_collection.arrival_usec)
+		return msg_collection.window;
+
+	/* Msgs are too sparse to be aggregated, don't hold them back */
+	if (msg_collection.arrival_usec >= max_usec)
+		return ADAPT_WINDOW_MIN;
+
+	window_usec = msg_collection.arrival_usec *
+		      (msg_collection.max_msg_cnt - 1);
+	window_usec = MAX(window_usec, msg_collection.send_usec);
+	window_usec = MAX(window_usec, min_usec);
+	window_usec = MIN(window_usec, max_usec);
+
+	return window_usec / 1000;
+}
+
 /*
  * _msg_aggregation_sender()
  *
@@ -193,10 +255,12 @@ static int _send_to_next_collector(slurm_msg_t *msg)
  */
 static void * _msg_aggregation_sender(void *arg)
 {
-	struct timeval now;
+	struct timeval now, window_start, send_start;
 	struct timespec timeout;
 	slurm_msg_t msg;
 	composite_msg_t cmp;
+	uint64_t window;
+	int wait_usec, msg_cnt;
 
 	msg_collection.running = 1;
 
@@ -212,10 +276,12 @@ static void * _msg_aggregation_sender(void *arg)
 			break;
 
 		/* A msg has been collected; start new window */
+		window = _get_window();
 		gettimeofday(&now, NULL);
-		timeout.tv_sec = now.tv_sec + (msg_collection.window / 1000);
+		window_start = now;
+		timeout.tv_sec = now.tv_sec + (window / 1000);
 		timeout.tv_nsec = (now.tv_usec * 1000) +
-			(1000000 * (msg_collection.window % 1000));
+			(1000000 * (window % 1000));
 		timeout.tv_sec += timeout.tv_nsec / 1000000000;
 		timeout.tv_nsec %= 1000000000;
 
@@ -236,6 +302,9 @@ static void * _msg_aggregation_sender(void *arg)
 		memcpy(&cmp.sender, &msg_collection.node_addr,
 		       sizeof(slurm_addr_t));
 		cmp.msg_list = msg_collection.msg_list;
+		wait_usec = slurm_delta_tv(&window_start);
+		cmp.window_time = wait_usec;
+		msg_cnt = list_count(cmp.msg_list);
 
 		msg_collection.msg_list =
 			list_create(slurm_free_comp_msg_list);
@@ -245,12 +314,30 @@ static void * _msg_aggregation_sender(void *arg)
 		msg.msg_type = MESSAGE_COMPOSITE;
 		msg.protocol_version = SLURM_PROTOCOL_VERSION;
 		msg.data = &cmp;
+		gettimeofday(&send_start, NULL);
 		if (_send_to_next_collector(&msg) != SLURM_SUCCESS) {
 			error("_msg_aggregation_engine: Unable to send "
 			      "composite msg: %m");
 		}
 		FREE_NULL_LIST(cmp.msg_list);
 
+		msg_collection.send_usec = _ewma(msg_collection.send_usec,
+						 slurm_delta_tv(&send_start));
+		msg_collection.stat_comp_cnt++;
+		msg_collection.stat_msg_cnt += msg_cnt;
+		msg_collection.stat_wait_usec += wait_usec;
+		if (msg_collection.debug_flags & DEBUG_FLAG_ROUTE) {
+			info("msg aggr: sent %d msgs after %d usec window "
+			     "(target %"PRIu64" ms), avg arrival %"PRIu64
+			     " usec, avg send %"PRIu64" usec, "
+			     "%"PRIu64" msgs in %"PRIu64" composites",
+			     msg_cnt, wait_usec, window,
+			     msg_collection.arrival_usec,
+			     msg_collection.send_usec,
+			     msg_collection.stat_msg_cnt,
+			     msg_collection.stat_comp_cnt);
+		}
+
 		/* Resume message collection */
 		slurm_cond_broadcast(&msg_collection.cond);
 	}
@@ -260,7 +347,7 @@ static void * _msg_aggregation_sender(void *arg)
 }
 
 extern void msg_aggr_sender_init(char *host, uint16_t port, uint64_t window,
-				 uint64_t max_msg_cnt)
+				 uint64_t window_max, uint64_t max_msg_cnt)
 {
 	if (msg_collection.running || (max_msg_cnt <= 1))
 		return;
@@ -275,6 +362,7 @@ extern void msg_aggr_sender_init(char *host, uint16_t port, uint64_t window,
 	slurm_cond_init(&msg_collection.cond, NULL);
 	slurm_set_addr(&msg_collection.node_addr, port, host);
 	msg_collection.window = window;
+	msg_collection.window_max = (window_max > window) ? window_max : 0;
 	msg_collection.max_msg_cnt = max_msg_cnt;
 	msg_collection.msg_aggr_list = list_create(_msg_aggr_free);
 	msg_collection.msg_list = list_create(slurm_free_comp_msg_list);
@@ -287,11 +375,14 @@ extern void msg_aggr_sender_init(char *host, uint16_t port, uint64_t window,
 			    &_msg_aggregation_sender, NULL);
 }
 
-extern void msg_aggr_sender_reconfig(uint64_t window, uint64_t max_msg_cnt)
+extern void msg_aggr_sender_reconfig(uint64_t window, uint64_t window_max,
+				     uint64_t max_msg_cnt)
 {
 	if (msg_collection.running) {
 		slurm_mutex_lock(&msg_collection.mutex);
 		msg_collection.window = window;
+		msg_collection.window_max =
+			(window_max > window) ? window_max : 0;
 		msg_collection.max_msg_cnt = max_msg_cnt;
 		msg_collection.debug_flags = slurm_get_debug_flags();
 		slurm_mutex_unlock(&msg_collection.mutex);
@@ -341,6 +432,21 @@ extern void msg_aggr_add_msg(slurm_msg_t *msg, bool wait,
 
 	msg->msg_index = msg_index++;
 
+	/* Track the msg arrival rate for adaptive windows */
+	if (msg_collection.window_max) {
+		if (msg_collection.last_arrival.tv_sec) {
+			/* Any gap beyond the max window is just "sparse" */
+			uint64_t max_usec = msg_collection.window_max * 1000;
+			int delta_usec =
+				slurm_delta_tv(&msg_collection.last_arrival);
+			if ((delta_usec < 0) || (delta_usec > max_usec))
+				delta_usec = max_usec;
+			msg_collection.arrival_usec = _ewma(
+				msg_collection.arrival_usec, delta_usec);
+		}
+		gettimeofday(&msg_collection.last_arrival, NULL);
+	}
+
 	/* Add msg to message collection */
 	list_append(msg_collection.msg_list, msg);
 
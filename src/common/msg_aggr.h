@@ -44,9 +44,18 @@
 
 #include "src/common/slurm_protocol_defs.h"
 
+/*
+ * Start the message aggregation sender.
+ * IN: host, port - address of this node, sent as composite msg sender
+ * IN: window - collection window in milliseconds
+ * IN: window_max - if greater than window, the collection window adapts to
+ *		    the msg arrival rate up to this many milliseconds
+ * IN: max_msg_cnt - maximum msgs per collection window
+ */
 extern void msg_aggr_sender_init(char *host, uint16_t port, uint64_t window,
-				 uint64_t max_msg_cnt);
-extern void msg_aggr_sender_reconfig(uint64_t window, uint64_t max_msg_cnt);
+				 uint64_t window_max, uint64_t max_msg_cnt);
+extern void msg_aggr_sender_reconfig(uint64_t window, uint64_t window_max,
+				     uint64_t max_msg_cnt);
 extern void msg_aggr_sender_fini(void);
 
 /* add a message that needs to be sent.
@@ -49,6 +49,7 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <inttypes.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -67,6 +68,8 @@
 #include "src/common/slurm_acct_gather_energy.h"
 #include "src/common/slurm_ext_sensors.h"
 #include "src/common/slurm_topology.h"
+#include "src/common/strnatcmp.h"
+#include "src/common/working_cluster.h"
 #include "src/common/xassert.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
@@ -83,6 +86,53 @@ int node_record_count = 0;		/* count in node_record_table_ptr */
 uint16_t *cr_node_num_cores = NULL;
 uint32_t *cr_node_cores_offset = NULL;
 
+/*
+ * Index of node names as groups of "<prefix><number>" sharing a prefix and
+ * number width, each group being contiguous and in hostlist sort order in
+ * node_record_table_ptr. When every node fits, node_name2bitmap() and
+ * bitmap2node_name() convert between bracketed expressions and bitmaps
+ * directly instead of through a hostlist.
+ */
+typedef struct name_group {
+	int first_inx;		/* node table index of first node in group */
+	int node_cnt;
+	char *prefix;
+	int prefix_len;
+	int width;		/* digits in each node's number */
+} name_group_t;
+
+static pthread_mutex_t name_index_lock = PTHREAD_MUTEX_INITIALIZER;
+static bool name_index_valid = false;	/* cleared when node table changes */
+static bool name_index_usable = false;	/* set if all node names fit */
+static name_group_t *name_groups = NULL;
+static int name_group_cnt = 0;
+static xhash_t *name_group_hash = NULL;	/* name_group_t by prefix */
+static int *name_group_inx = NULL;	/* group of each node */
+static uint32_t *name_number = NULL;	/* number of each node */
+static int name_max_len = 0;
+
+/*
+ * Least recently used cache of node_name2bitmap() and bitmap2node_name()
+ * results, for node lists converted over and over again (partition and
+ * reservation nodes, common job allocations). Entries are found by a hash
+ * of the names or a digest of the bitmap, then compared in full. Purged
+ * with the node name index.
+ */
+#define NAME_CACHE_SIZE	64
+
+typedef struct name_cache_ent {
+	bitstr_t *bitmap;
+	uint32_t bitmap_digest;
+	bool canonical;		/* names is bitmap2node_name() of bitmap */
+	uint32_t last_use;
+	char *names;
+	uint32_t names_hash;
+} name_cache_ent_t;
+
+static pthread_mutex_t name_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static name_cache_ent_t name_cache[NAME_CACHE_SIZE];
+static uint32_t name_cache_clock = 0;
+
 /* Local function defiitions */
 static int	_build_single_nodeline_info(slurm_conf_node_t *node_ptr,
 					    struct config_record *config_ptr);
@@ -94,6 +144,9 @@ static struct node_record *
 		_find_node_record (char *name,bool test_alias,bool log_missing);
 static void	_list_delete_config (void *config_entry);
 static int	_list_find_config (void *config_entry, void *key);
+static void	_name_index_free(void);
+static void	_name_index_invalidate(void);
+static bool	_name_index_validate(void);
 static const char* _node_record_hash_identity (void* item);
 
 /*
@@ -354,6 +407,417 @@ static const char* _node_record_hash_identity (void* item)
 	return node_ptr->name;
 }
 
+static const char *_name_group_hash_identity(void *item)
+{
+	name_group_t *group = (name_group_t *) item;
+	return group->prefix;
+}
+
+static void _name_index_free(void)
+{
+	int i;
+
+	xhash_free(name_group_hash);
+	for (i = 0; i < name_group_cnt; i++)
+		xfree(name_groups[i].prefix);
+	xfree(name_groups);
+	name_group_cnt = 0;
+	xfree(name_group_inx);
+	xfree(name_number);
+	name_max_len = 0;
+	name_index_usable = false;
+}
+
+/* Build the node name index, leave name_index_usable clear if some node's
+ * name does not fit it. */
+static void _name_index_build(void)
+{
+	struct node_record *node_ptr = node_record_table_ptr;
+	name_group_t *group = NULL;
+	char *name;
+	int i, len, prefix_len, width;
+
+	_name_index_free();
+	if (node_record_count == 0)
+		return;
+
+	name_groups = xmalloc(sizeof(name_group_t) * node_record_count);
+	name_group_inx = xmalloc(sizeof(int) * node_record_count);
+	name_number = xmalloc(sizeof(uint32_t) * node_record_count);
+	for (i = 0; i < node_record_count; i++, node_ptr++) {
+		name = node_ptr->name;
+		if (!name || (name[0] == '\0'))
+			goto unusable;	/* vestigial record */
+		len = strlen(name);
+		prefix_len = len;
+		while ((prefix_len > 0) && isdigit((int) name[prefix_len - 1]))
+			prefix_len--;
+		width = len - prefix_len;
+		if ((width == 0) || (width > 9))
+			goto unusable;
+		if (group && (group->prefix_len == prefix_len) &&
+		    !strncmp(group->prefix, name, prefix_len)) {
+			/* hostlist would not merge this into the group */
+			if ((group->width != width) ||
+			    (name_number[i - 1] >= strtoul(name + prefix_len,
+							   NULL, 10)))
+				goto unusable;
+			group->node_cnt++;
+		} else {
+			group = &name_groups[name_group_cnt++];
+			group->first_inx = i;
+			group->node_cnt = 1;
+			group->prefix = xstrndup(name, prefix_len);
+			group->prefix_len = prefix_len;
+			group->width = width;
+			/* groups must be in hostlist prefix order */
+			if ((name_group_cnt > 1) &&
+			    (strnatcmp(name_groups[name_group_cnt - 2].prefix,
+				       group->prefix) >= 0))
+				goto unusable;
+		}
+		name_group_inx[i] = name_group_cnt - 1;
+		name_number[i] = strtoul(name + prefix_len, NULL, 10);
+		name_max_len = MAX(name_max_len, len);
+	}
+
+	name_group_hash = xhash_init(_name_group_hash_identity, NULL, NULL, 0);
+	for (i = 0; i < name_group_cnt; i++)
+		xhash_add(name_group_hash, &name_groups[i]);
+	name_index_usable = true;
+	return;
+
+unusable:
+	debug2("%s: node names do not fit the name index", __func__);
+	_name_index_free();
+}
+
+static uint32_t _name_cache_names_hash(char *names)
+{
+	uint32_t hash = 5381;
+
+	while (*names)
+		hash = (hash * 33) + (unsigned char) *names++;
+	return hash;
+}
+
+static uint32_t _name_cache_bitmap_digest(bitstr_t *bitmap)
+{
+	uint32_t digest = bit_size(bitmap);
+
+	digest = (digest * 31) + bit_ffs(bitmap);
+	digest = (digest * 31) + bit_fls(bitmap);
+	digest = (digest * 31) + bit_set_count(bitmap);
+	return digest;
+}
+
+/* Copy the cached bitmap of names into bitmap, return false if none */
+static bool _name_cache_get_bitmap(char *names, bitstr_t *bitmap)
+{
+	uint32_t hash = _name_cache_names_hash(names);
+	name_cache_ent_t *ent;
+	bool found = false;
+	int i;
+
+	slurm_mutex_lock(&name_cache_lock);
+	for (i = 0, ent = name_cache; i < NAME_CACHE_SIZE; i++, ent++) {
+		if (!ent->names || (ent->names_hash != hash) ||
+		    (bit_size(ent->bitmap) != bit_size(bitmap)) ||
+		    xstrcmp(ent->names, names))
+			continue;
+		bit_copybits(bitmap, ent->bitmap);
+		ent->last_use = ++name_cache_clock;
+		found = true;
+		break;
+	}
+	slurm_mutex_unlock(&name_cache_lock);
+
+	return found;
+}
+
+/* Return a copy of the cached sorted names of bitmap or NULL if none */
+static char *_name_cache_get_names(bitstr_t *bitmap)
+{
+	uint32_t digest = _name_cache_bitmap_digest(bitmap);
+	name_cache_ent_t *ent;
+	char *names = NULL;
+	int i;
+
+	slurm_mutex_lock(&name_cache_lock);
+	for (i = 0, ent = name_cache; i < NAME_CACHE_SIZE; i++, ent++) {
+		if (!ent->names || !ent->canonical ||
+		    (ent->bitmap_digest != digest) ||
+		    !bit_equal(ent->bitmap, bitmap))
+			continue;
+		names = xstrdup(ent->names);
+		ent->last_use = ++name_cache_clock;
+		break;
+	}
+	slurm_mutex_unlock(&name_cache_lock);
+
+	return names;
+}
+
+/* Add a conversion to the cache, replacing the least recently used entry */
+static void _name_cache_add(char *names, bitstr_t *bitmap, bool canonical)
+{
+	name_cache_ent_t *ent, *victim = name_cache;
+	int i;
+
+	slurm_mutex_lock(&name_cache_lock);
+	for (i = 0, ent = name_cache; i < NAME_CACHE_SIZE; i++, ent++) {
+		if (!ent->names) {
+			victim = ent;
+			break;
+		}
+		if (ent->last_use < victim->last_use)
+			victim = ent;
+	}
+	xfree(victim->names);
+	FREE_NULL_BITMAP(victim->bitmap);
+	victim->bitmap = bit_copy(bitmap);
+	victim->bitmap_digest = _name_cache_bitmap_digest(bitmap);
+	victim->canonical = canonical;
+	victim->last_use = ++name_cache_clock;
+	victim->names = xstrdup(names);
+	victim->names_hash = _name_cache_names_hash(names);
+	slurm_mutex_unlock(&name_cache_lock);
+}
+
+static void _name_cache_purge(void)
+{
+	name_cache_ent_t *ent;
+	int i;
+
+	slurm_mutex_lock(&name_cache_lock);
+	for (i = 0, ent = name_cache; i < NAME_CACHE_SIZE; i++, ent++) {
+		xfree(ent->names);
+		FREE_NULL_BITMAP(ent->bitmap);
+	}
+	name_cache_clock = 0;
+	slurm_mutex_unlock(&name_cache_lock);
+}
+
+/* Discard the node name index after node records are added or moved */
+static void _name_index_invalidate(void)
+{
+	slurm_mutex_lock(&name_index_lock);
+	name_index_valid = false;
+	_name_index_free();
+	slurm_mutex_unlock(&name_index_lock);
+	_name_cache_purge();
+}
+
+/* Return true if the node name index can be used, building it if needed */
+static bool _name_index_validate(void)
+{
+	bool usable;
+
+	if (is_cray_system() || (slurmdb_setup_cluster_name_dims() > 1))
+		return false;
+
+	slurm_mutex_lock(&name_index_lock);
+	if (!name_index_valid) {
+		_name_index_build();
+		name_index_valid = true;
+	}
+	usable = name_index_usable;
+	slurm_mutex_unlock(&name_index_lock);
+
+	return usable;
+}
+
+/* Append the numbers of the range of nodes run_first to run_last */
+static void _name_range_cat(char *buf, int *len, int run_first, int run_last)
+{
+	int width = name_groups[name_group_inx[run_first]].width;
+
+	*len += sprintf(buf + *len, "%0*u", width, name_number[run_first]);
+	if (run_last != run_first) {
+		*len += sprintf(buf + *len, "-%0*u", width,
+				name_number[run_last]);
+	}
+}
+
+/* Close a group's brackets, dropping them if the group has only one host */
+static void _name_group_close(char *buf, int *len, int bracket,
+			      int group_hosts)
+{
+	if (group_hosts > 1) {
+		buf[(*len)++] = ']';
+	} else {
+		memmove(buf + bracket, buf + bracket + 1, *len - bracket - 1);
+		(*len)--;
+	}
+}
+
+/*
+ * Build the sorted, ranged node name string of bitmap from the node name
+ * index, as hostlist_ranged_string() of the sorted hostlist would.
+ */
+static char *_bitmap2node_name_index(bitstr_t *bitmap)
+{
+	name_group_t *group;
+	char *buf;
+	int i, first, last, len = 0, bracket = 0, group_hosts = 0;
+	int g = -1, run_first = -1, run_last = -1;
+
+	first = bit_ffs(bitmap);
+	if (first == -1)
+		return xstrdup("");
+	last = bit_fls(bitmap);
+	buf = xmalloc((bit_set_count(bitmap) * (name_max_len + 3)) + 1);
+
+	for (i = first; i <= last; i++) {
+		if (!bit_test(bitmap, i))
+			continue;
+		if ((name_group_inx[i] == g) &&
+		    (name_number[i] == (name_number[run_last] + 1))) {
+			run_last = i;
+			group_hosts++;
+			continue;
+		}
+		if (run_first != -1)
+			_name_range_cat(buf, &len, run_first, run_last);
+		if (name_group_inx[i] != g) {
+			if (g != -1) {
+				_name_group_close(buf, &len, bracket,
+						  group_hosts);
+				buf[len++] = ',';
+			}
+			g = name_group_inx[i];
+			group = &name_groups[g];
+			memcpy(buf + len, group->prefix, group->prefix_len);
+			len += group->prefix_len;
+			bracket = len;
+			buf[len++] = '[';
+			group_hosts = 0;
+		} else {
+			buf[len++] = ',';
+		}
+		run_first = run_last = i;
+		group_hosts++;
+	}
+	_name_range_cat(buf, &len, run_first, run_last);
+	_name_group_close(buf, &len, bracket, group_hosts);
+	buf[len] = '\0';
+
+	return buf;
+}
+
+/* Find the node of a group with the given number, return -1 if none */
+static int _name_group_find(name_group_t *group, uint32_t number)
+{
+	int lo = group->first_inx, hi = group->first_inx + group->node_cnt;
+	int mid;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (name_number[mid] < number)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if ((lo < (group->first_inx + group->node_cnt)) &&
+	    (name_number[lo] == number))
+		return lo;
+	return -1;
+}
+
+/* Parse a number of exactly width digits at *str, advancing *str */
+static bool _name_number_parse(char **str, int width, uint32_t *number)
+{
+	char *end;
+
+	if (!isdigit((int) **str))
+		return false;
+	*number = strtoul(*str, &end, 10);
+	if ((end - *str) != width)
+		return false;
+	*str = end;
+	return true;
+}
+
+/*
+ * Set the bits of node_names in bitmap using the node name index and node
+ * hash table. Only "name" and "prefix[ranges]" expressions naming existing
+ * nodes are handled.
+ * RET false if node_names needs a hostlist, bitmap may then be partly set
+ */
+static bool _node_name2bitmap_index(char *node_names, bitstr_t *bitmap)
+{
+	struct node_record *node_ptr;
+	name_group_t *group;
+	char name[128], *tok = node_names, *end, *open;
+	uint32_t lo, hi;
+	int lo_inx, hi_inx, len;
+
+	while (*tok) {
+		open = NULL;
+		for (end = tok; *end && (*end != ','); end++) {
+			if (*end == '[') {
+				if (open)
+					return false;
+				open = end;
+			} else if (isspace((int) *end)) {
+				return false;
+			}
+		}
+		len = (open ? open : end) - tok;
+		if ((len == 0) || (len >= sizeof(name)))
+			return false;
+		memcpy(name, tok, len);
+		name[len] = '\0';
+
+		if (!open) {
+			if (strchr(name, ']') || !node_hash_table ||
+			    !(node_ptr = xhash_get(node_hash_table, name)))
+				return false;
+			bit_set(bitmap, node_ptr - node_record_table_ptr);
+			tok = *end ? end + 1 : end;
+			continue;
+		}
+
+		/* prefix[lo-hi,...] of a group, ',' inside the brackets
+		 * ended the scan above so parse the ranges from open */
+		if (isdigit((int) name[len - 1]) ||
+		    !(group = xhash_get(name_group_hash, name)))
+			return false;
+		tok = open + 1;
+		while (1) {
+			if (!_name_number_parse(&tok, group->width, &lo))
+				return false;
+			hi = lo;
+			if (*tok == '-') {
+				tok++;
+				if (!_name_number_parse(&tok, group->width,
+							&hi))
+					return false;
+			}
+			if ((hi < lo) ||
+			    ((lo_inx = _name_group_find(group, lo)) == -1) ||
+			    ((hi_inx = _name_group_find(group, hi)) == -1) ||
+			    ((hi_inx - lo_inx) != (hi - lo)))
+				return false;
+			bit_nset(bitmap, lo_inx, hi_inx);
+			if (*tok == ',') {
+				tok++;
+			} else if (*tok == ']') {
+				tok++;
+				break;
+			} else {
+				return false;
+			}
+		}
+		if (*tok == ',')
+			tok++;
+		else if (*tok)
+			return false;
+	}
+
+	return true;
+}
+
 /*
  * bitmap2hostlist - given a bitmap, build a hostlist
  * IN bitmap - bitmap pointer
@@ -399,6 +863,21 @@ char * bitmap2node_name_sortable (bitstr_t *bitmap, bool sort)
 	hostlist_t hl;
 	char *buf;
 
+	if (sort && bitmap) {
+		if ((buf = _name_cache_get_names(bitmap)))
+			return buf;
+		if (_name_index_validate())
+			buf = _bitmap2node_name_index(bitmap);
+		else if ((hl = bitmap2hostlist(bitmap))) {
+			hostlist_sort(hl);
+			buf = hostlist_ranged_string_xmalloc(hl);
+			hostlist_destroy(hl);
+		} else
+			buf = xstrdup("");
+		_name_cache_add(buf, bitmap, true);
+		return buf;
+	}
+
 	hl = bitmap2hostlist (bitmap);
 	if (hl == NULL)
 		return xstrdup("");
@@ -650,6 +1129,7 @@ extern struct node_record *create_node_record (
 	}
 	node_ptr = node_record_table_ptr + (node_record_count++);
 	node_ptr->name = xstrdup(node_name);
+	_name_index_invalidate();
 	if (!node_hash_table)
 		node_hash_table = xhash_init(_node_record_hash_identity,
 					     NULL, NULL, 0);
@@ -787,6 +1267,7 @@ extern int init_node_conf (void)
 	node_record_count = 0;
 	xfree(node_record_table_ptr);
 	xhash_free(node_hash_table);
+	_name_index_invalidate();
 
 	if (config_list)	/* delete defunct configuration entries */
 		(void) _delete_config_record ();
@@ -811,6 +1292,7 @@ extern void node_fini2 (void)
 	}
 
 	xhash_free(node_hash_table);
+	_name_index_invalidate();
 	node_ptr = node_record_table_ptr;
 	for (i = 0; i < node_record_count; i++, node_ptr++)
 		purge_node_rec(node_ptr);
@@ -836,6 +1318,7 @@ extern int node_name2bitmap (char *node_names, bool best_effort,
 	char *this_node_name;
 	bitstr_t *my_bitmap;
 	hostlist_t host_list;
+	bool all_valid = true;
 
 	my_bitmap = (bitstr_t *) bit_alloc (node_record_count);
 	*bitmap = my_bitmap;
@@ -845,6 +1328,17 @@ extern int node_name2bitmap (char *node_names, bool best_effort,
 		return rc;
 	}
 
+	if (_name_cache_get_bitmap(node_names, my_bitmap))
+		return rc;
+
+	if (_name_index_validate()) {
+		if (_node_name2bitmap_index(node_names, my_bitmap)) {
+			_name_cache_add(node_names, my_bitmap, false);
+			return rc;
+		}
+		bit_nclear(my_bitmap, 0, node_record_count - 1);
+	}
+
 	if ( (host_list = hostlist_create (node_names)) == NULL) {
 		/* likely a badly formatted hostlist */
 		error ("hostlist_create on %s error:", node_names);
@@ -864,11 +1358,14 @@ extern int node_name2bitmap (char *node_names, bool best_effort,
 			       this_node_name);
 			if (!best_effort)
 				rc = EINVAL;
+			all_valid = false;
 		}
 		free (this_node_name);
 	}
 	hostlist_destroy (host_list);
 
+	if (all_valid)
+		_name_cache_add(node_names, my_bitmap, false);
 	return rc;
 }
 
@@ -947,6 +1444,7 @@ extern void rehash_node (void)
 	struct node_record *node_ptr = node_record_table_ptr;
 
 	xhash_free (node_hash_table);
+	_name_index_invalidate();
 	node_hash_table = xhash_init(_node_record_hash_identity,
 				     NULL, NULL, 0);
 	for (i = 0; i < node_record_count; i++, node_ptr++) {
@@ -94,6 +94,7 @@ typedef struct slurm_jobacct_gather_ops {
 			   bool profile);
 	int (*endpoll)    ();
 	int (*add_task)   (pid_t pid, jobacct_id_t *jobacct_id);
+	int (*sample_node) (char *file_name, uint16_t interval);
 } slurm_jobacct_gather_ops_t;
 
 /*
@@ -104,6 +105,7 @@ static const char *syms[] = {
 	"jobacct_gather_p_poll_data",
 	"jobacct_gather_p_endpoll",
 	"jobacct_gather_p_add_task",
+	"jobacct_gather_p_sample_node",
 };
 
 static slurm_jobacct_gather_ops_t ops;
@@ -128,6 +130,8 @@ static uint32_t jobacct_step_id    = 0;
 static uint64_t jobacct_mem_limit  = 0;
 static uint64_t jobacct_vmem_limit = 0;
 
+static char *node_sample_file = NULL;
+
 /* _acct_kill_step() issue RPC to kill a slurm job step */
 static void _acct_kill_step(void)
 {
@@ -335,6 +339,7 @@ extern int jobacct_gather_fini(void)
 		rc = plugin_context_destroy(g_context);
 		g_context = NULL;
 	}
+	xfree(node_sample_file);
 	slurm_mutex_unlock(&g_context_lock);
 
 	return rc;
@@ -543,6 +548,64 @@ extern int jobacct_gather_set_proctrack_container_id(uint64_t id)
 	return SLURM_SUCCESS;
 }
 
+extern char *jobacct_gather_node_sample_file(char *spooldir)
+{
+	char *acct_params, *file_name = NULL;
+
+	if ((jobacct_gather_init() < 0) || !plugin_polling || !spooldir)
+		return NULL;
+
+	acct_params = slurm_get_jobacct_gather_params();
+	if (acct_params && xstrcasestr(acct_params, "SharedSampler"))
+		file_name = xstrdup_printf("%s/jobacct_node_sample", spooldir);
+	xfree(acct_params);
+
+	return file_name;
+}
+
+extern void jobacct_gather_set_node_sample_file(char *file_name)
+{
+	slurm_mutex_lock(&g_context_lock);
+	xfree(node_sample_file);
+	node_sample_file = file_name;
+	slurm_mutex_unlock(&g_context_lock);
+}
+
+extern char *jobacct_gather_get_node_sample_file(void)
+{
+	return node_sample_file;
+}
+
+extern uint16_t jobacct_gather_get_poll_freq(void)
+{
+	return (uint16_t) freq;
+}
+
+extern int jobacct_gather_sample_node(char *file_name, uint16_t interval)
+{
+	int (*sample_node) (char *file_name, uint16_t interval) = NULL;
+
+	if (!plugin_polling)
+		return SLURM_SUCCESS;
+
+	if (jobacct_gather_init() < 0)
+		return SLURM_ERROR;
+
+	/*
+	 * Walking /proc takes a while, so don't hold g_context_lock and block
+	 * every other plugin call meanwhile. The caller stops sampling before
+	 * calling jobacct_gather_fini().
+	 */
+	slurm_mutex_lock(&g_context_lock);
+	if (g_context)
+		sample_node = ops.sample_node;
+	slurm_mutex_unlock(&g_context_lock);
+	if (!sample_node)
+		return SLURM_ERROR;
+
+	return (*sample_node)(file_name, interval);
+}
+
 extern int jobacct_gather_set_mem_limit(uint32_t job_id,
 					uint32_t step_id,
 					uint64_t mem_limit)
@@ -564,6 +627,11 @@ extern int jobacct_gather_set_mem_limit(uint32_t job_id,
 	return SLURM_SUCCESS;
 }
 
+extern uint64_t jobacct_gather_get_vmem_limit(void)
+{
+	return jobacct_vmem_limit;
+}
+
 extern void jobacct_gather_handle_mem_limit(uint64_t total_job_mem,
 					    uint64_t total_job_vsize)
 {
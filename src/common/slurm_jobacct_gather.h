@@ -147,9 +147,30 @@ extern jobacctinfo_t *jobacct_gather_stat_task(pid_t pid);
 extern jobacctinfo_t *jobacct_gather_remove_task(pid_t pid);
 
 extern int jobacct_gather_set_proctrack_container_id(uint64_t id);
+
+/*
+ * With JobAcctGatherParams=SharedSampler the slurmd samples all processes
+ * of the node once per interval and publishes the result in a file of its
+ * spool directory. The slurmstepds look up the processes of their step in
+ * it rather than each walking /proc.
+ */
+/* RET xmalloc'ed name of the node sample file or NULL if not in use */
+extern char *jobacct_gather_node_sample_file(char *spooldir);
+/* Make the polling use the node samples in file_name, consumes file_name */
+extern void jobacct_gather_set_node_sample_file(char *file_name);
+extern char *jobacct_gather_get_node_sample_file(void);
+/* RET task accounting frequency of the step in seconds, 0 if not polling */
+extern uint16_t jobacct_gather_get_poll_freq(void);
+/*
+ * Publish a new node sample in file_name, called by the slurmd. Runs without
+ * the plugin context lock, so it must not overlap jobacct_gather_fini().
+ */
+extern int jobacct_gather_sample_node(char *file_name, uint16_t interval);
 extern int jobacct_gather_set_mem_limit(uint32_t job_id,
 					uint32_t step_id,
 					uint64_t mem_limit);
+/* RET virtual memory limit of the step in KB, 0 if not enforced */
+extern uint64_t jobacct_gather_get_vmem_limit(void);
 extern void jobacct_gather_handle_mem_limit(uint64_t total_job_mem,
 					    uint64_t total_job_vsize);
 
@@ -4454,6 +4454,58 @@ cleanup:
 	return rc;
 }
 
+/* slurm_send_recv_replica_msg
+ * sends an information request to the backup controller, which may answer
+ * it from its replica of the primary controller's state. Falls back to
+ * slurm_send_recv_controller_msg() if the backup does not answer it.
+ * IN request_msg	- slurm_msg request
+ * OUT response_msg	- slurm_msg response
+ * IN comm_cluster_rec	- Communication record (host/port/version)/
+ *			  if set, the request goes straight to that cluster
+ * RET int 		- returns 0 on success, -1 on failure and sets errno
+ */
+extern int slurm_send_recv_replica_msg(slurm_msg_t *request_msg,
+				       slurm_msg_t *response_msg,
+				       slurmdb_cluster_rec_t *comm_cluster_rec)
+{
+	int fd, rc;
+
+	if (comm_cluster_rec)
+		goto controller;
+	if ((fd = slurm_open_controller_conn_spec(SECONDARY_CONTROLLER,
+						  NULL)) < 0) {
+		debug("Failed to contact secondary controller: %m");
+		goto controller;
+	}
+
+	forward_init(&request_msg->forward, NULL);
+	request_msg->ret_list = NULL;
+	request_msg->forward_struct = NULL;
+	rc = _send_and_recv_msg(fd, request_msg, response_msg, 0);
+	if (response_msg->auth_cred)
+		g_slurm_auth_destroy(response_msg->auth_cred);
+	else
+		rc = -1;
+	if (rc != 0)
+		goto controller;
+
+	if ((response_msg->msg_type == RESPONSE_SLURM_RC) &&
+	    ((((return_code_msg_t *) response_msg->data)->return_code) ==
+	     ESLURM_IN_STANDBY_MODE)) {
+		/* The backup has no current replica of this information */
+		slurm_free_return_code_msg(response_msg->data);
+		response_msg->data = NULL;
+		goto controller;
+	}
+
+	return rc;
+
+controller:
+	slurm_msg_t_init(response_msg);
+	return slurm_send_recv_controller_msg(request_msg, response_msg,
+					      comm_cluster_rec);
+}
+
 /* slurm_send_recv_node_msg
  * opens a connection to node, sends the node a message, listens
  * for the response, then closes the connection
@@ -1216,6 +1216,20 @@ extern int slurm_send_recv_controller_msg(slurm_msg_t * request_msg,
 				slurm_msg_t * response_msg,
 				slurmdb_cluster_rec_t *comm_cluster_rec);
 
+/* slurm_send_recv_replica_msg
+ * sends an information request to the backup controller, which may answer
+ * it from its replica of the primary controller's state. Falls back to
+ * slurm_send_recv_controller_msg() if the backup does not answer it.
+ * IN request_msg	- slurm_msg request
+ * OUT response_msg	- slurm_msg response
+ * IN comm_cluster_rec	- Communication record (host/port/version)/
+ *			  if set, the request goes straight to that cluster
+ * RET int 		- returns 0 on success, -1 on failure and sets errno
+ */
+extern int slurm_send_recv_replica_msg(slurm_msg_t *request_msg,
+				       slurm_msg_t *response_msg,
+				       slurmdb_cluster_rec_t *comm_cluster_rec);
+
 
 /* slurm_send_recv_node_msg
  * opens a connection to node,
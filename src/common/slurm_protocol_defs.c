@@ -757,6 +757,10 @@ extern void slurm_free_job_info_request_msg(job_info_request_msg_t *msg)
 {
 	if (msg) {
 		FREE_NULL_LIST(msg->job_ids);
+		xfree(msg->filter.accounts);
+		xfree(msg->filter.partitions);
+		xfree(msg->filter.states);
+		xfree(msg->filter.user_ids);
 		xfree(msg);
 	}
 }
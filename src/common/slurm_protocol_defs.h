@@ -587,6 +587,7 @@ typedef struct job_info_request_msg {
 	uint16_t show_flags;
 	List   job_ids;		/* Optional list of job_ids, otherwise show all
 				 * jobs. */
+	job_info_filter_t filter; /* Optional job filter, see slurm.h */
 } job_info_request_msg_t;
 
 typedef struct job_step_info_request_msg {
@@ -889,6 +890,8 @@ typedef struct network_callerid_resp {
 typedef struct composite_msg {
 	slurm_addr_t sender;	/* address of sending node/port */
 	List	 msg_list;
+	uint32_t window_time;	/* usec msgs were held in the collection
+				 * window before being sent */
 } composite_msg_t;
 
 typedef struct set_fs_dampening_factor_msg {
@@ -5082,6 +5082,8 @@ _pack_composite_msg(composite_msg_t *msg, Buf buffer, uint16_t protocol_version)
 	pack32(count, buffer);
 
 	slurm_pack_slurm_addr(&msg->sender, buffer);
+	if (protocol_version >= SLURM_17_11_PROTOCOL_VERSION)
+		pack32(msg->window_time, buffer);
 	if (count && count != NO_VAL) {
 		itr = list_iterator_create(msg->msg_list);
 		while ((tmp_info = list_next(itr))) {
@@ -5136,7 +5138,7 @@ _unpack_composite_msg(composite_msg_t **msg, Buf buffer,
 {
 	uint32_t count = NO_VAL;
 	int i, rc;
-	slurm_msg_t *tmp_info;
+	slurm_msg_t *tmp_info = NULL;
 	composite_msg_t *object_ptr = NULL;
 	char *auth_info = slurm_get_auth_info();
 
@@ -5145,6 +5147,8 @@ _unpack_composite_msg(composite_msg_t **msg, Buf buffer,
 	*msg = object_ptr;
 	safe_unpack32(&count, buffer);
 	slurm_unpack_slurm_addr_no_alloc(&object_ptr->sender, buffer);
+	if (protocol_version >= SLURM_17_11_PROTOCOL_VERSION)
+		safe_unpack32(&object_ptr->window_time, buffer);
 
 	if (count > NO_VAL32)
 		goto unpack_error;
@@ -10410,9 +10414,8 @@ _pack_launch_tasks_request_msg(launch_tasks_request_msg_t * msg, Buf buffer,
 		slurm_cred_pack(msg->cred, buffer, protocol_version);
 		for (i = 0; i < msg->nnodes; i++) {
 			pack16(msg->tasks_to_launch[i], buffer);
-			pack32_array(msg->global_task_ids[i],
-				     (uint32_t) msg->tasks_to_launch[i],
-				     buffer);
+			pack_task_id_runs(msg->global_task_ids[i],
+					  msg->tasks_to_launch[i], buffer);
 		}
 		pack16(msg->num_resp_port, buffer);
 		for (i = 0; i < msg->num_resp_port; i++)
@@ -10667,6 +10670,7 @@ _unpack_launch_tasks_request_msg(launch_tasks_request_msg_t **
 {
 	uint32_t cluster_flags = slurmdb_setup_cluster_flags();
 	uint32_t uint32_tmp = 0;
+	uint16_t uint16_tmp = 0;
 	launch_tasks_request_msg_t *msg;
 	int i = 0;
 
@@ -10718,10 +10722,10 @@ _unpack_launch_tasks_request_msg(launch_tasks_request_msg_t **
 					       msg->nnodes);
 		for (i = 0; i < msg->nnodes; i++) {
 			safe_unpack16(&msg->tasks_to_launch[i], buffer);
-			safe_unpack32_array(&msg->global_task_ids[i],
-					    &uint32_tmp,
-					    buffer);
-			if (msg->tasks_to_launch[i] != (uint16_t) uint32_tmp)
+			if (unpack_task_id_runs(&msg->global_task_ids[i],
+						&uint16_tmp, buffer))
+				goto unpack_error;
+			if (msg->tasks_to_launch[i] != uint16_tmp)
 				goto unpack_error;
 		}
 		safe_unpack16(&msg->num_resp_port, buffer);
@@ -11881,6 +11885,11 @@ _pack_job_info_request_msg(job_info_request_msg_t * msg, Buf buffer,
 			list_iterator_destroy(itr);
 		}
 
+		packstr(msg->filter.accounts, buffer);
+		packstr(msg->filter.partitions, buffer);
+		pack32_array(msg->filter.states, msg->filter.state_cnt, buffer);
+		pack32_array(msg->filter.user_ids, msg->filter.user_cnt,
+			     buffer);
 	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		pack_time(msg->last_update, buffer);
 		pack16((uint16_t)msg->show_flags, buffer);
@@ -11920,6 +11929,15 @@ _unpack_job_info_request_msg(job_info_request_msg_t** msg,
 				uint32_ptr = NULL;
 			}
 		}
+
+		safe_unpackstr_xmalloc(&job_info->filter.accounts, &count,
+				       buffer);
+		safe_unpackstr_xmalloc(&job_info->filter.partitions, &count,
+				       buffer);
+		safe_unpack32_array(&job_info->filter.states,
+				    &job_info->filter.state_cnt, buffer);
+		safe_unpack32_array(&job_info->filter.user_ids,
+				    &job_info->filter.user_cnt, buffer);
 	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		safe_unpack_time(&job_info->last_update, buffer);
 		safe_unpack16(&job_info->show_flags, buffer);
@@ -15070,6 +15088,13 @@ static int  _unpack_stats_response_msg(stats_info_response_msg_t **msg_ptr,
 			safe_unpack32(&msg->bf_depth_try_sum,	buffer);
 			safe_unpack32(&msg->bf_queue_len_sum,	buffer);
 			safe_unpack32(&msg->bf_active,		buffer);
+
+			if (protocol_version >= SLURM_17_11_PROTOCOL_VERSION) {
+				safe_unpack32(&msg->aggr_comp_cnt,   buffer);
+				safe_unpack32(&msg->aggr_msg_cnt,    buffer);
+				safe_unpack64(&msg->aggr_window_sum, buffer);
+				safe_unpack32(&msg->aggr_window_max, buffer);
+			}
 		}
 
 		safe_unpack32(&msg->rpc_type_size,		buffer);
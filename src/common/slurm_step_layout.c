@@ -239,7 +239,25 @@ extern void pack_slurm_step_layout(slurm_step_layout_t *step_layout,
 {
 	uint32_t i = 0;
 
-	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
+	if (protocol_version >= SLURM_17_11_PROTOCOL_VERSION) {
+		if (step_layout)
+			i = 1;
+
+		pack16(i, buffer);
+		if (!i)
+			return;
+		packstr(step_layout->front_end, buffer);
+		packstr(step_layout->node_list, buffer);
+		pack32(step_layout->node_cnt, buffer);
+		pack16(step_layout->start_protocol_ver, buffer);
+		pack32(step_layout->task_cnt, buffer);
+		pack32(step_layout->task_dist, buffer);
+
+		for (i = 0; i < step_layout->node_cnt; i++) {
+			pack_task_id_runs(step_layout->tids[i],
+					  step_layout->tasks[i], buffer);
+		}
+	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		if (step_layout)
 			i = 1;
 
@@ -272,7 +290,34 @@ extern int unpack_slurm_step_layout(slurm_step_layout_t **layout, Buf buffer,
 	slurm_step_layout_t *step_layout = NULL;
 	int i;
 
-	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
+	if (protocol_version >= SLURM_17_11_PROTOCOL_VERSION) {
+		safe_unpack16(&uint16_tmp, buffer);
+		if (!uint16_tmp)
+			return SLURM_SUCCESS;
+
+		step_layout = xmalloc(sizeof(slurm_step_layout_t));
+		*layout = step_layout;
+
+		safe_unpackstr_xmalloc(&step_layout->front_end,
+				       &uint32_tmp, buffer);
+		safe_unpackstr_xmalloc(&step_layout->node_list,
+				       &uint32_tmp, buffer);
+		safe_unpack32(&step_layout->node_cnt, buffer);
+		safe_unpack16(&step_layout->start_protocol_ver, buffer);
+		safe_unpack32(&step_layout->task_cnt, buffer);
+		safe_unpack32(&step_layout->task_dist, buffer);
+
+		step_layout->tasks =
+			xmalloc(sizeof(uint16_t) * step_layout->node_cnt);
+		step_layout->tids = xmalloc(sizeof(uint32_t *)
+					    * step_layout->node_cnt);
+		for (i = 0; i < step_layout->node_cnt; i++) {
+			if (unpack_task_id_runs(&step_layout->tids[i],
+						&step_layout->tasks[i],
+						buffer))
+				goto unpack_error;
+		}
+	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		safe_unpack16(&uint16_tmp, buffer);
 		if (!uint16_tmp)
 			return SLURM_SUCCESS;
@@ -312,6 +357,101 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+/* Return the index of the last task ID in the run of equally spaced task
+ * IDs starting at index first, set stride to their spacing */
+static int _tids_run_end(uint32_t *tids, uint16_t task_cnt, int first,
+			 uint32_t *stride)
+{
+	int last = first;
+
+	*stride = 0;
+	if ((first + 1) < task_cnt) {
+		*stride = tids[first + 1] - tids[first];
+		for (last = first + 1; ((last + 1) < task_cnt) &&
+			     ((tids[last + 1] - tids[last]) == *stride); last++)
+			;
+	}
+	return last;
+}
+
+/*
+ * Pack a node's task IDs as runs of "first, stride, count" when that is
+ * shorter, as it is for block, cyclic and plane distributions, otherwise
+ * as an array. A run count of zero precedes the array.
+ */
+extern void pack_task_id_runs(uint32_t *tids, uint16_t task_cnt, Buf buffer)
+{
+	uint32_t run_cnt = 0, stride;
+	int i, j;
+
+	for (i = 0; i < task_cnt; i = j + 1) {
+		j = _tids_run_end(tids, task_cnt, i, &stride);
+		run_cnt++;
+	}
+
+	if ((run_cnt * 3) >= task_cnt) {
+		pack32(0, buffer);
+		pack32_array(tids, task_cnt, buffer);
+		return;
+	}
+
+	pack32(run_cnt, buffer);
+	for (i = 0; i < task_cnt; i = j + 1) {
+		j = _tids_run_end(tids, task_cnt, i, &stride);
+		pack32(tids[i], buffer);
+		pack32(stride, buffer);
+		pack32(j - i + 1, buffer);
+	}
+}
+
+extern int unpack_task_id_runs(uint32_t **tids, uint16_t *task_cnt,
+			       Buf buffer)
+{
+	uint32_t run_cnt, first, stride, cnt, total = 0, uint32_tmp;
+	uint32_t *runs = NULL;
+	int i, j, k = 0;
+
+	safe_unpack32(&run_cnt, buffer);
+	if (run_cnt == 0) {
+		safe_unpack32_array(tids, &uint32_tmp, buffer);
+		if (uint32_tmp > UINT16_MAX)
+			goto unpack_error;
+		*task_cnt = uint32_tmp;
+		return SLURM_SUCCESS;
+	}
+	/* Each run is three uint32_t values, don't trust run_cnt beyond
+	 * what the message can hold */
+	if ((run_cnt > UINT16_MAX) ||
+	    (remaining_buf(buffer) < (run_cnt * 3 * sizeof(uint32_t))))
+		goto unpack_error;
+
+	runs = xmalloc(sizeof(uint32_t) * run_cnt * 3);
+	for (i = 0; i < run_cnt; i++) {
+		safe_unpack32(&runs[i * 3], buffer);
+		safe_unpack32(&runs[i * 3 + 1], buffer);
+		safe_unpack32(&runs[i * 3 + 2], buffer);
+		if (runs[i * 3 + 2] > (UINT16_MAX - total))
+			goto unpack_error;
+		total += runs[i * 3 + 2];
+	}
+
+	*tids = xmalloc(sizeof(uint32_t) * total);
+	for (i = 0; i < run_cnt; i++) {
+		first  = runs[i * 3];
+		stride = runs[i * 3 + 1];
+		cnt    = runs[i * 3 + 2];
+		for (j = 0; j < cnt; j++)
+			(*tids)[k++] = first + (j * stride);
+	}
+	*task_cnt = total;
+	xfree(runs);
+	return SLURM_SUCCESS;
+
+unpack_error:
+	xfree(runs);
+	return SLURM_ERROR;
+}
+
 /* destroys structure for step layout */
 extern int slurm_step_layout_destroy(slurm_step_layout_t *step_layout)
 {
@@ -671,28 +811,43 @@ static int _task_layout_block(slurm_step_layout_t *step_layout, uint16_t *cpus)
 static int _task_layout_cyclic(slurm_step_layout_t *step_layout,
 			       uint16_t *cpus)
 {
-	int i, j, taskid = 0;
-	bool over_subscribe = false;
-
-	for (j=0; taskid<step_layout->task_cnt; j++) {   /* cycle counter */
-		bool space_remaining = false;
-		for (i=0; ((i<step_layout->node_cnt)
-			   && (taskid<step_layout->task_cnt)); i++) {
-			if ((j<cpus[i]) || over_subscribe) {
-				xrealloc(step_layout->tids[i], sizeof(uint32_t)
-					 * (step_layout->tasks[i] + 1));
-
-				step_layout->tids[i][step_layout->tasks[i]] =
-					taskid;
-				taskid++;
-				step_layout->tasks[i]++;
-				if ((j+1) < cpus[i])
-					space_remaining = true;
+	int i, j, pass, taskid;
+	bool over_subscribe;
+	uint16_t *cur_task;
+
+	cur_task = xmalloc(sizeof(uint16_t) * step_layout->node_cnt);
+	/* Pass 0 counts each node's tasks so that pass 1 can fill the
+	 * tids arrays without growing them a task at a time */
+	for (pass = 0; pass < 2; pass++) {
+		taskid = 0;
+		over_subscribe = false;
+		memset(cur_task, 0, sizeof(uint16_t) * step_layout->node_cnt);
+		for (j = 0; taskid < step_layout->task_cnt; j++) {
+			bool space_remaining = false;
+			for (i = 0; ((i < step_layout->node_cnt) &&
+				     (taskid < step_layout->task_cnt)); i++) {
+				if ((j < cpus[i]) || over_subscribe) {
+					if (pass)
+						step_layout->tids[i]
+							[cur_task[i]] = taskid;
+					cur_task[i]++;
+					taskid++;
+					if ((j + 1) < cpus[i])
+						space_remaining = true;
+				}
 			}
+			if (!space_remaining)
+				over_subscribe = true;
+		}
+		if (pass)
+			break;
+		for (i = 0; i < step_layout->node_cnt; i++) {
+			step_layout->tasks[i] = cur_task[i];
+			step_layout->tids[i] = xmalloc(sizeof(uint32_t) *
+						       cur_task[i]);
 		}
-		if (!space_remaining)
-			over_subscribe = true;
 	}
+	xfree(cur_task);
 	return SLURM_SUCCESS;
 }
 
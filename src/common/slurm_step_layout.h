@@ -78,6 +78,11 @@ extern void pack_slurm_step_layout(slurm_step_layout_t *step_layout,
 extern int unpack_slurm_step_layout(slurm_step_layout_t **layout, Buf buffer,
 				    uint16_t protocol_version);
 
+/* pack and unpack one node's task IDs, as runs when that is shorter */
+extern void pack_task_id_runs(uint32_t *tids, uint16_t task_cnt, Buf buffer);
+extern int unpack_task_id_runs(uint32_t **tids, uint16_t *task_cnt,
+			       Buf buffer);
+
 /* destroys structure for step layout */
 extern int slurm_step_layout_destroy(slurm_step_layout_t *step_layout);
 
@@ -46,6 +46,7 @@
 #include "src/common/slurm_protocol_defs.h"
 #include "src/common/slurm_time.h"
 #include "src/common/slurmdb_defs.h"
+#include "src/common/xhash.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
 #include "src/slurmdbd/read_config.h"
@@ -617,6 +618,7 @@ extern slurmdb_assoc_usage_t *slurmdb_create_assoc_usage(int tres_cnt)
 	usage->usage_raw = 0;
 	usage->level_fs = 0;
 	usage->fs_factor = 0;
+	usage->fs_dirty = true;
 
 	usage->tres_cnt = tres_cnt;
 
@@ -652,6 +654,7 @@ extern void slurmdb_destroy_assoc_usage(void *object)
 
 	if (usage) {
 		FREE_NULL_LIST(usage->children_list);
+		xfree(usage->fs_children);
 		FREE_NULL_BITMAP(usage->valid_qos);
 		xfree(usage->grp_used_tres_run_secs);
 		xfree(usage->grp_used_tres);
@@ -666,8 +669,10 @@ extern void slurmdb_destroy_qos_usage(void *object)
 		(slurmdb_qos_usage_t *)object;
 
 	if (usage) {
+		xhash_free_ptr((xhash_t **) &usage->acct_limit_hash);
 		FREE_NULL_LIST(usage->acct_limit_list);
 		FREE_NULL_LIST(usage->job_list);
+		xhash_free_ptr((xhash_t **) &usage->user_limit_hash);
 		FREE_NULL_LIST(usage->user_limit_list);
 		xfree(usage->grp_used_tres_run_secs);
 		xfree(usage->grp_used_tres);
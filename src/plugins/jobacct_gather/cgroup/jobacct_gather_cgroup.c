@@ -98,6 +98,7 @@ const uint32_t plugin_version = SLURM_VERSION_NUMBER;
 
 /* Other useful declarations */
 static slurm_cgroup_conf_t slurm_cgroup_conf;
+static bool use_cgroup_stats = false;	/* JobAcctGatherParams=UseCgroupStats */
 
 static void _prec_extra(jag_prec_t *prec)
 {
@@ -183,6 +184,156 @@ static void _prec_extra(jag_prec_t *prec)
 
 }
 
+/*
+ * Find a "<key> <value>" line of a cgroup statistics file
+ * RET true if key was found
+ */
+static bool _get_stat_value(char *content, const char *key, uint64_t *value)
+{
+	int len = strlen(key);
+	char *line = content;
+
+	while (line && *line) {
+		if (!strncmp(line, key, len) && (line[len] == ' ')) {
+			*value = strtoull(line + len + 1, NULL, 10);
+			return true;
+		}
+		if ((line = strchr(line, '\n')))
+			line++;
+	}
+
+	return false;
+}
+
+/*
+ * Sum /proc/<pid>/io of the processes listed in the task cgroup, as the
+ * blkio cgroups are not set up by this plugin. A process that exits while
+ * being read is skipped.
+ */
+static void _get_task_io(uint32_t taskid, jag_prec_t *prec)
+{
+	char *procs = NULL, *ptr, *end, path[64], buf[512];
+	size_t psize = 0;
+	uint64_t rchar, wchar, total_read = 0, total_write = 0;
+	pid_t pid;
+	int fd, len;
+
+	if (jobacct_gather_cgroup_cpuacct_get_task_param(
+		    taskid, "cgroup.procs", &procs, &psize) != SLURM_SUCCESS)
+		return;
+
+	for (ptr = procs; ptr && *ptr; ptr = end) {
+		pid = (pid_t) strtol(ptr, &end, 10);
+		if (end == ptr)
+			break;
+		snprintf(path, sizeof(path), "/proc/%d/io", (int) pid);
+		if ((fd = open(path, O_RDONLY | O_CLOEXEC)) < 0)
+			continue;
+		len = read(fd, buf, sizeof(buf) - 1);
+		(void) close(fd);
+		if (len <= 0)
+			continue;
+		buf[len] = '\0';
+		if (_get_stat_value(buf, "rchar:", &rchar) &&
+		    _get_stat_value(buf, "wchar:", &wchar)) {
+			total_read += rchar;
+			total_write += wchar;
+		}
+	}
+	xfree(procs);
+
+	prec->disk_read = (double)total_read / (double)1048576;
+	prec->disk_write = (double)total_write / (double)1048576;
+}
+
+/*
+ * Fill prec from the cpuacct and memory cgroups of the task. All the
+ * processes of the task are accounted by the kernel in these, so the cost
+ * does not depend on the number of processes the task forked. Only the
+ * disk I/O is still read per process.
+ */
+static int _get_task_stats(uint32_t taskid, jag_prec_t *prec)
+{
+	char *content = NULL;
+	size_t csize = 0;
+	uint64_t value;
+	int rc = SLURM_ERROR;
+
+	if (jobacct_gather_cgroup_cpuacct_get_task_param(
+		    taskid, "cpuacct.stat", &content, &csize) != SLURM_SUCCESS)
+		return SLURM_ERROR;
+	if (!_get_stat_value(content, "user", &value))
+		goto fini;
+	prec->usec = value;
+	if (!_get_stat_value(content, "system", &value))
+		goto fini;
+	prec->ssec = value;
+	xfree(content);
+
+	if (jobacct_gather_cgroup_memory_get_task_param(
+		    taskid, "memory.stat", &content, &csize) != SLURM_SUCCESS)
+		return SLURM_ERROR;
+	if (!_get_stat_value(content, "total_rss", &value))
+		goto fini;
+	prec->rss = value / 1024; /* convert from bytes to KB */
+	if (_get_stat_value(content, "total_pgmajfault", &value))
+		prec->pages = value;
+	_get_task_io(taskid, prec);
+	rc = SLURM_SUCCESS;
+
+fini:
+	xfree(content);
+	return rc;
+}
+
+/*
+ * Build one jag_prec_t per task from its cgroup counters instead of
+ * walking the processes in /proc. If a task cgroup can not be read (e.g.
+ * the task is not attached yet) this poll falls back to /proc. So does a
+ * step with a virtual memory limit, as cgroups don't account the virtual
+ * size needed to enforce it.
+ */
+static List _get_precs_cgroup(List task_list, bool pgid_plugin,
+			      uint64_t cont_id, jag_callbacks_t *callbacks)
+{
+	List prec_list = list_create(destroy_jag_prec);
+	struct jobacctinfo *jobacct;
+	ListIterator itr;
+	jag_prec_t *prec;
+	int rc = SLURM_SUCCESS;
+
+	if (!task_list)
+		return prec_list;
+
+	if (jobacct_gather_get_vmem_limit()) {
+		FREE_NULL_LIST(prec_list);
+		return jag_common_get_precs(task_list, pgid_plugin, cont_id,
+					    callbacks);
+	}
+
+	itr = list_iterator_create(task_list);
+	while ((jobacct = list_next(itr))) {
+		prec = xmalloc(sizeof(jag_prec_t));
+		prec->pid = jobacct->pid;
+		rc = _get_task_stats(jobacct->id.taskid, prec);
+		if (rc != SLURM_SUCCESS) {
+			xfree(prec);
+			break;
+		}
+		list_append(prec_list, prec);
+	}
+	list_iterator_destroy(itr);
+
+	if (rc != SLURM_SUCCESS) {
+		debug2("%s: task cgroups not usable, reading /proc", __func__);
+		FREE_NULL_LIST(prec_list);
+		return jag_common_get_precs(task_list, pgid_plugin, cont_id,
+					    callbacks);
+	}
+
+	return prec_list;
+}
+
 static bool _run_in_daemon(void)
 {
 	static bool set = false;
@@ -206,12 +357,19 @@ extern int init (void)
 	   isn't needed.
 	*/
 	if (_run_in_daemon()) {
+		char *acct_params;
+
 		jag_common_init(0);
 
 		/* read cgroup configuration */
 		if (read_slurm_cgroup_conf(&slurm_cgroup_conf))
 			return SLURM_ERROR;
 
+		acct_params = slurm_get_jobacct_gather_params();
+		if (acct_params && xstrcasestr(acct_params, "UseCgroupStats"))
+			use_cgroup_stats = true;
+		xfree(acct_params);
+
 		/* initialize cpuinfo internal data */
 		if (xcpuinfo_init() != XCPUINFO_SUCCESS) {
 			free_slurm_cgroup_conf(&slurm_cgroup_conf);
@@ -291,6 +449,8 @@ extern void jobacct_gather_p_poll_data(
 		memset(&callbacks, 0, sizeof(jag_callbacks_t));
 		first = 0;
 		callbacks.prec_extra = _prec_extra;
+		if (use_cgroup_stats)
+			callbacks.get_precs = _get_precs_cgroup;
 	}
 
 	jag_common_poll_data(task_list, pgid_plugin, cont_id, &callbacks,
@@ -323,6 +483,15 @@ extern int jobacct_gather_p_add_task(pid_t pid, jobacct_id_t *jobacct_id)
 	return SLURM_SUCCESS;
 }
 
+/*
+ * jobacct_gather_p_sample_node() - Publish a sample of all the processes of
+ * the node, see jag_common_sample_node().
+ */
+extern int jobacct_gather_p_sample_node(char *file_name, uint16_t interval)
+{
+	return jag_common_sample_node(file_name, interval);
+}
+
 extern char* jobacct_cgroup_create_slurm_cg(xcgroup_ns_t* ns)
  {
 	/* we do it here as we do not have access to the conf structure */
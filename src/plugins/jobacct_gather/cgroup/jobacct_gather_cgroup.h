@@ -55,6 +55,10 @@ extern int jobacct_gather_cgroup_cpuacct_fini(
 extern int jobacct_gather_cgroup_cpuacct_attach_task(
 	pid_t pid, jobacct_id_t *jobacct_id);
 
+/* Read a parameter of the cpuacct cgroup of a task of the step */
+extern int jobacct_gather_cgroup_cpuacct_get_task_param(
+	uint32_t taskid, char *param, char **content, size_t *csize);
+
 extern int jobacct_gather_cgroup_memory_init(
 	slurm_cgroup_conf_t *slurm_cgroup_conf);
 
@@ -64,6 +68,10 @@ extern int jobacct_gather_cgroup_memory_fini(
 extern int jobacct_gather_cgroup_memory_attach_task(
 	pid_t pid, jobacct_id_t *jobacct_id);
 
+/* Read a parameter of the memory cgroup of a task of the step */
+extern int jobacct_gather_cgroup_memory_get_task_param(
+	uint32_t taskid, char *param, char **content, size_t *csize);
+
 /* FIXME: Enable when kernel support ready. */
  /* extern xcgroup_t task_blkio_cg; */
 /* extern int jobacct_gather_cgroup_blkio_init( */
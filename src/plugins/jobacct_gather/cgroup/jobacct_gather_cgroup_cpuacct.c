@@ -384,3 +384,25 @@ error:
 	xcgroup_destroy(&cpuacct_cg);
 	return fstatus;
 }
+
+extern int
+jobacct_gather_cgroup_cpuacct_get_task_param(uint32_t taskid, char *param,
+					    char **content, size_t *csize)
+{
+	xcgroup_t cgroup;
+	char buf[PATH_MAX];
+
+	if (jobstep_cgroup_path[0] == '\0')
+		return SLURM_ERROR;
+
+	if (snprintf(buf, PATH_MAX, "%s%s/task_%u", cpuacct_ns.mnt_point,
+		     jobstep_cgroup_path, taskid) >= PATH_MAX)
+		return SLURM_ERROR;
+	cgroup.path = buf;
+
+	if (xcgroup_get_param(&cgroup, param, content, csize) !=
+	    XCGROUP_SUCCESS)
+		return SLURM_ERROR;
+
+	return SLURM_SUCCESS;
+}
@@ -41,8 +41,9 @@
 #include <dirent.h>
 #include <fcntl.h>
 #include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <time.h>
-#include <ctype.h>
 
 #include "src/common/slurm_xlator.h"
 #include "src/common/slurm_jobacct_gather.h"
@@ -57,11 +58,55 @@
 static int cpunfo_frequency = 0;
 static long hertz = 0;
 
+/*
+ * Indexes of the /proc/<pid>/stat fields we use, numbered as in proc(5).
+ * Fields 1 (pid), 2 (comm) and 3 (state) are handled separately.
+ */
+enum {
+	STAT_PPID = 4,
+	STAT_MAJFLT = 12,
+	STAT_UTIME = 14,
+	STAT_STIME = 15,
+	STAT_VSIZE = 23,
+	STAT_RSS = 24,
+	STAT_PROCESSOR = 39,
+	STAT_FIELD_CNT
+};
+
+/* Open /proc/<pid> files of a process in the proctrack container */
+typedef struct {
+	int	io_fd;
+	int	is_lwp;		/* -1 if not checked yet */
+	pid_t	pid;
+	uint32_t poll_id;	/* last poll the process was seen in */
+	int	smaps_fd;	/* smaps or smaps_rollup, only with UsePss */
+	int	stat_fd;
+	int	statm_fd;	/* only with NoShare */
+} jag_proc_fds_t;
+
 static int my_pagesize = 0;
 static DIR  *slash_proc = NULL;
 static int energy_profile = ENERGY_DATA_NODE_ENERGY_UP;
 static uint64_t debug_flags = 0;
 
+static int no_share_data = -1;
+static int use_pss = -1;
+static bool have_smaps_rollup = false;
+
+/*
+ * Descriptors kept open between polls. The first proc_fds_sorted entries
+ * are sorted by pid for bsearch(), processes first seen during a poll are
+ * appended and the array is sorted again at the end of the poll.
+ */
+static jag_proc_fds_t *proc_fds = NULL;
+static int proc_fds_cnt = 0;
+static int proc_fds_size = 0;
+static int proc_fds_sorted = 0;
+static uint32_t poll_id = 0;
+static pthread_mutex_t node_sample_lock = PTHREAD_MUTEX_INITIALIZER;
+static char *proc_buf = NULL;
+static int proc_buf_size = 0;
+
 static int _find_prec(void *x, void *key)
 {
 	jag_prec_t *prec = (jag_prec_t *) x;
@@ -126,62 +171,109 @@ inline static bool _get_freq(char *str)
 }
 
 /*
- * collects the Pss value from /proc/<pid>/smaps
+ * Read the whole content of an already open /proc file into proc_buf,
+ * starting from offset 0 so the same descriptor can be re-read on each
+ * poll without being reopened.
+ * RET length of data read, or -1 on error (e.g. the process went away)
  */
-static int _get_pss(char *proc_smaps_file, jag_prec_t *prec)
+static int _read_proc_fd(int fd)
 {
-        uint64_t pss;
-	uint64_t p;
-        char line[128];
-        FILE *fp;
-	int i;
+	int len = 0, rc;
 
-	fp = fopen(proc_smaps_file, "r");
-        if (!fp) {
-                return -1;
-        }
+	while (1) {
+		if ((proc_buf_size - len) < 128) {
+			proc_buf_size = MAX(proc_buf_size * 2, 4096);
+			proc_buf = xrealloc_nz(proc_buf, proc_buf_size);
+		}
+		rc = pread(fd, proc_buf + len, proc_buf_size - len - 1, len);
+		if (rc < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		if (rc == 0)
+			break;
+		len += rc;
+	}
+	proc_buf[len] = '\0';
 
-	if (fcntl(fileno(fp), F_SETFD, FD_CLOEXEC) == -1)
-		error("%s: fcntl(%s): %m", __func__, proc_smaps_file);
-	pss = 0;
+	return len;
+}
 
-        while (fgets(line,sizeof(line),fp)) {
+/*
+ * Parse a decimal number at *str, skipping leading blanks, and move *str
+ * past it. This replaces sscanf() on the hot polling path.
+ * RET true if a number was found
+ */
+static bool _scan_num(char **str, int64_t *value)
+{
+	char *p = *str;
+	int64_t val = 0;
+	bool neg = false;
+
+	while ((*p == ' ') || (*p == '\t'))
+		p++;
+	if (*p == '-') {
+		neg = true;
+		p++;
+	}
+	if ((*p < '0') || (*p > '9'))
+		return false;
+	while ((*p >= '0') && (*p <= '9'))
+		val = (val * 10) + (*p++ - '0');
 
-                if (xstrncmp(line, "Pss:", 4) != 0) {
-                        continue;
-                }
+	*value = neg ? -val : val;
+	*str = p;
+	return true;
+}
 
-                for (i = 4; i < sizeof(line); i++) {
+/*
+ * Sum the "Pss:" lines of smaps (one line per mapping) or smaps_rollup
+ * (a single line) content held in proc_buf.
+ */
+static uint64_t _scan_pss(int len)
+{
+	char *p = proc_buf, *end = proc_buf + len;
+	uint64_t pss = 0;
+	int64_t val;
+
+	while (p < end) {
+		if (!xstrncmp(p, "Pss:", 4)) {
+			p += 4;
+			if (_scan_num(&p, &val))
+				pss += val;
+		}
+		if (!(p = strchr(p, '\n')))
+			break;
+		p++;
+	}
 
-                        if (!isdigit(line[i])) {
-                                continue;
-                        }
-                        if (sscanf(&line[i],"%"PRIu64"", &p) == 1) {
-                                pss += p;
-                        }
-                        break;
-                }
-        }
+	return pss;
+}
 
-	/* Check for error
-	 */
-	if (ferror(fp)) {
-		error("%s: ferror() indicates error on file %s",
-		      __func__, proc_smaps_file);
-		fclose(fp);
+/*
+ * collects the Pss value from /proc/<pid>/smaps or, when the kernel
+ * provides it, the much cheaper to generate /proc/<pid>/smaps_rollup
+ */
+static int _get_pss(int fd, jag_prec_t *prec)
+{
+	uint64_t pss;
+	int len;
+
+	if ((len = _read_proc_fd(fd)) < 0)
 		return -1;
-	}
 
-        fclose(fp);
-        /* Sanity checks */
-        if (pss > 0 && prec->rss > pss) {
-                prec->rss = pss;
-        }
+	pss = _scan_pss(len);
+
+	/* Sanity checks */
+	if (pss > 0 && prec->rss > pss) {
+		prec->rss = pss;
+	}
 
-	debug3("%s: read pss %"PRIu64" for process %s",
-	       __func__, pss, proc_smaps_file);
+	debug3("%s: read pss %"PRIu64" for process %d",
+	       __func__, pss, prec->pid);
 
-        return 0;
+	return 0;
 }
 
 static int _get_sys_interface_freq_line(uint32_t cpu, char *filename,
@@ -276,7 +368,7 @@ static int _is_a_lwp(uint32_t pid) {
 
 /* _get_process_data_line() - get line of data from /proc/<pid>/stat
  *
- * IN:	in - input file descriptor
+ * IN:	len - length of the file content in proc_buf
  * OUT:	prec - the destination for the data
  *
  * RETVAL:	==0 - no valid data
@@ -284,75 +376,56 @@ static int _is_a_lwp(uint32_t pid) {
  *
  * Based upon stat2proc() from the ps command. It can handle arbitrary
  * executable file basenames for `cmd', i.e. those with embedded whitespace or
- * embedded ')'s. Such names confuse %s (see scanf(3)), so the string is split
- * and %39c is used instead. (except for embedded ')' "(%[^)]c)" would work.
+ * embedded ')'s, by looking for the last ')' in the line. The numeric fields
+ * are then parsed by hand, field numbers as in proc(5).
  */
-static int _get_process_data_line(int in, jag_prec_t *prec) {
-	char sbuf[512], *tmp;
-	int num_read, nvals;
-	char cmd[40], state[1];
-	int ppid, pgrp, session, tty_nr, tpgid;
-	long unsigned flags, minflt, cminflt, majflt, cmajflt;
-	long unsigned utime, stime, starttime, vsize;
-	long int cutime, cstime, priority, nice, timeout, itrealvalue, rss;
-	long unsigned f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13;
-	int exit_signal, last_cpu;
-
-	num_read = read(in, sbuf, (sizeof(sbuf) - 1));
-	if (num_read <= 0)
-		return 0;
-	sbuf[num_read] = '\0';
+static int _get_process_data_line(int len, jag_prec_t *prec)
+{
+	char *p, *tmp;
+	int64_t field[STAT_FIELD_CNT];
+	int64_t pid;
+	int i;
 
-	/*
-	 * split into "PID (cmd" and "<rest>" replace trailing ')' with NULL
-	 */
-	tmp = strrchr(sbuf, ')');
-	if (!tmp)
+	if (len <= 0)
 		return 0;
-	*tmp = '\0';
 
-	/* parse these two strings separately, skipping the leading "(". */
-	nvals = sscanf(sbuf, "%d (%39c", &prec->pid, cmd);
-	if (nvals < 2)
+	/* split into "PID (cmd" and "<rest>" */
+	tmp = strrchr(proc_buf, ')');
+	if (!tmp || (tmp[1] != ' '))
 		return 0;
 
-	nvals = sscanf(tmp + 2,	 /* skip space after ')' too */
-		       "%c %d %d %d %d %d "
-		       "%lu %lu %lu %lu %lu "
-		       "%lu %lu %ld %ld %ld %ld "
-		       "%ld %ld %lu %lu %ld "
-		       "%lu %lu %lu %lu %lu "
-		       "%lu %lu %lu %lu %lu "
-		       "%lu %lu %lu %d %d ",
-		       state, &ppid, &pgrp, &session, &tty_nr, &tpgid,
-		       &flags, &minflt, &cminflt, &majflt, &cmajflt,
-		       &utime, &stime, &cutime, &cstime, &priority, &nice,
-		       &timeout, &itrealvalue, &starttime, &vsize, &rss,
-		       &f1, &f2, &f3, &f4, &f5 ,&f6, &f7, &f8, &f9, &f10, &f11,
-		       &f12, &f13, &exit_signal, &last_cpu);
-	/* There are some additional fields, which we do not scan or use */
-	if ((nvals < 37) || (rss < 0))
+	p = proc_buf;
+	if (!_scan_num(&p, &pid) || (p[0] != ' ') || (p[1] != '('))
 		return 0;
+	prec->pid = pid;
 
-	/* If current pid corresponds to a Light Weight Process (Thread POSIX) */
-	/* skip it, we will only account the original process (pid==tgid) */
-	if (_is_a_lwp(prec->pid) > 0)
+	/* skip space after ')' and the one character state field */
+	p = tmp + 2;
+	if (!*p || (p[1] != ' '))
+		return 0;
+	p += 2;
+	for (i = STAT_PPID; i < STAT_FIELD_CNT; i++) {
+		if (!_scan_num(&p, &field[i]))
+			return 0;
+	}
+	/* There are some additional fields, which we do not scan or use */
+	if (field[STAT_RSS] < 0)
 		return 0;
 
 	/* Copy the values that slurm records into our data structure */
-	prec->ppid  = ppid;
-	prec->pages = majflt;
-	prec->usec  = utime;
-	prec->ssec  = stime;
-	prec->vsize = vsize / 1024; /* convert from bytes to KB */
-	prec->rss   = rss * my_pagesize;/* convert from pages to KB */
-	prec->last_cpu = last_cpu;
+	prec->ppid  = field[STAT_PPID];
+	prec->pages = field[STAT_MAJFLT];
+	prec->usec  = field[STAT_UTIME];
+	prec->ssec  = field[STAT_STIME];
+	prec->vsize = field[STAT_VSIZE] / 1024; /* convert from bytes to KB */
+	prec->rss   = field[STAT_RSS] * my_pagesize;/* convert from pages to KB */
+	prec->last_cpu = field[STAT_PROCESSOR];
 	return 1;
 }
 
 /* _get_process_memory_line() - get line of data from /proc/<pid>/statm
  *
- * IN:	in - input file descriptor
+ * IN:	len - length of the file content in proc_buf
  * OUT:	prec - the destination for the data
  *
  * RETVAL:	==0 - no valid data
@@ -363,22 +436,17 @@ static int _get_process_data_line(int in, jag_prec_t *prec) {
  * and return the updated struct.
  *
  */
-static int _get_process_memory_line(int in, jag_prec_t *prec)
+static int _get_process_memory_line(int len, jag_prec_t *prec)
 {
-	char sbuf[256];
-	int num_read, nvals;
-	long int size, rss, share, text, lib, data, dt;
+	char *p = proc_buf;
+	int64_t size, rss, share;
 
-	num_read = read(in, sbuf, (sizeof(sbuf) - 1));
-	if (num_read <= 0)
+	if (len <= 0)
 		return 0;
-	sbuf[num_read] = '\0';
 
-	nvals = sscanf(sbuf,
-		       "%ld %ld %ld %ld %ld %ld %ld",
-		       &size, &rss, &share, &text, &lib, &data, &dt);
 	/* There are some additional fields, which we do not scan or use */
-	if (nvals != 7)
+	if (!_scan_num(&p, &size) || !_scan_num(&p, &rss) ||
+	    !_scan_num(&p, &share))
 		return 0;
 
 	/* If shared > rss then there is a problem, give up... */
@@ -392,27 +460,9 @@ static int _get_process_memory_line(int in, jag_prec_t *prec)
 	return 1;
 }
 
-static int _remove_share_data(char *proc_stat_file, jag_prec_t *prec)
-{
-	FILE *statm_fp = NULL;
-	char proc_statm_file[256];	/* Allow ~20x extra length */
-	int rc = 0, fd;
-
-	snprintf(proc_statm_file, sizeof(proc_statm_file), "%sm",
-		 proc_stat_file);
-	if (!(statm_fp = fopen(proc_statm_file, "r")))
-		return rc;  /* Assume the process went away */
-	fd = fileno(statm_fp);
-	if (fcntl(fd, F_SETFD, FD_CLOEXEC) == -1)
-		error("%s: fcntl(%s): %m", __func__, proc_statm_file);
-	rc = _get_process_memory_line(fd, prec);
-	fclose(statm_fp);
-	return rc;
-}
-
 /* _get_process_io_data_line() - get line of data from /proc/<pid>/io
  *
- * IN:	in - input file descriptor
+ * IN:	len - length of the file content in proc_buf
  * OUT:	prec - the destination for the data
  *
  * RETVAL:	==0 - no valid data
@@ -423,23 +473,21 @@ static int _remove_share_data(char *proc_stat_file, jag_prec_t *prec)
  * wrchar: <# of characters written>
  *   . . .
  */
-static int _get_process_io_data_line(int in, jag_prec_t *prec) {
-	char sbuf[256];
-	char f1[7], f3[7];
-	int num_read, nvals;
-	uint64_t rchar, wchar;
-
-	num_read = read(in, sbuf, (sizeof(sbuf) - 1));
-	if (num_read <= 0)
-		return 0;
-	sbuf[num_read] = '\0';
+static int _get_process_io_data_line(int len, jag_prec_t *prec)
+{
+	char *p;
+	int64_t rchar, wchar;
 
-	nvals = sscanf(sbuf, "%s %"PRIu64" %s %"PRIu64"",
-		       f1, &rchar, f3, &wchar);
-	if (nvals < 4)
+	if (len <= 0)
 		return 0;
 
-	if (_is_a_lwp(prec->pid) > 0)
+	if (!(p = strchr(proc_buf, ':')))
+		return 0;
+	p++;
+	if (!_scan_num(&p, &rchar) || !(p = strchr(p, ':')))
+		return 0;
+	p++;
+	if (!_scan_num(&p, &wchar))
 		return 0;
 
 	/* Copy the values that slurm records into our data structure */
@@ -449,15 +497,112 @@ static int _get_process_io_data_line(int in, jag_prec_t *prec) {
 	return 1;
 }
 
-static void _handle_stats(List prec_list, char *proc_stat_file, char *proc_io_file,
-			  char *proc_smaps_file, jag_callbacks_t *callbacks)
+static int _open_proc_file(pid_t pid, const char *name)
 {
-	static int no_share_data = -1;
-	static int use_pss = -1;
-	FILE *stat_fp = NULL;
-	FILE *io_fp = NULL;
-	int fd, fd2;
+	char path[64];
+	int fd;
+
+	snprintf(path, sizeof(path), "/proc/%d/%s", (int) pid, name);
+	/* Close the file on exec() of user tasks */
+	if ((fd = open(path, O_RDONLY | O_CLOEXEC)) < 0)
+		debug3("%s: unable to open %s: %m", __func__, path);
+	return fd;
+}
+
+static void _close_proc_fds(jag_proc_fds_t *fds)
+{
+	if (fds->stat_fd >= 0)
+		(void) close(fds->stat_fd);
+	if (fds->statm_fd >= 0)
+		(void) close(fds->statm_fd);
+	if (fds->io_fd >= 0)
+		(void) close(fds->io_fd);
+	if (fds->smaps_fd >= 0)
+		(void) close(fds->smaps_fd);
+	fds->stat_fd = fds->statm_fd = fds->io_fd = fds->smaps_fd = -1;
+}
+
+static int _open_proc_fds(jag_proc_fds_t *fds)
+{
+	if ((fds->stat_fd = _open_proc_file(fds->pid, "stat")) < 0)
+		return SLURM_ERROR;  /* Assume the process went away */
+	if (no_share_data)
+		fds->statm_fd = _open_proc_file(fds->pid, "statm");
+	if (use_pss)
+		fds->smaps_fd = _open_proc_file(fds->pid, have_smaps_rollup ?
+						"smaps_rollup" : "smaps");
+	fds->io_fd = _open_proc_file(fds->pid, "io");
+	fds->is_lwp = -1;
+
+	return SLURM_SUCCESS;
+}
+
+static int _cmp_proc_fds_pid(const void *x, const void *y)
+{
+	pid_t pid1 = ((jag_proc_fds_t *) x)->pid;
+	pid_t pid2 = ((jag_proc_fds_t *) y)->pid;
+
+	if (pid1 < pid2)
+		return -1;
+	return (pid1 > pid2);
+}
+
+static jag_proc_fds_t *_find_proc_fds(pid_t pid)
+{
+	jag_proc_fds_t key;
+
+	key.pid = pid;
+	return bsearch(&key, proc_fds, proc_fds_sorted,
+		       sizeof(jag_proc_fds_t), _cmp_proc_fds_pid);
+}
+
+static jag_proc_fds_t *_add_proc_fds(pid_t pid)
+{
+	jag_proc_fds_t *fds;
+
+	if (proc_fds_cnt >= proc_fds_size) {
+		proc_fds_size = MAX(proc_fds_size * 2, 64);
+		proc_fds = xrealloc(proc_fds,
+				    sizeof(jag_proc_fds_t) * proc_fds_size);
+	}
+	fds = &proc_fds[proc_fds_cnt++];
+	memset(fds, 0, sizeof(jag_proc_fds_t));
+	fds->pid = pid;
+
+	return fds;
+}
+
+/*
+ * Close the descriptors of processes not seen in the current poll and sort
+ * the remaining ones for the next poll's lookups
+ */
+static void _purge_proc_fds(void)
+{
+	bool added = (proc_fds_cnt > proc_fds_sorted);
+	int i, j = 0;
+
+	for (i = 0; i < proc_fds_cnt; i++) {
+		if (proc_fds[i].poll_id != poll_id) {
+			_close_proc_fds(&proc_fds[i]);
+			continue;
+		}
+		if (i != j)
+			proc_fds[j] = proc_fds[i];
+		j++;
+	}
+	proc_fds_cnt = j;
+	if (added)
+		qsort(proc_fds, proc_fds_cnt, sizeof(jag_proc_fds_t),
+		      _cmp_proc_fds_pid);
+	proc_fds_sorted = proc_fds_cnt;
+}
+
+static void _handle_stats(List prec_list, pid_t pid, bool keep_fds,
+			  jag_callbacks_t *callbacks)
+{
+	jag_proc_fds_t local_fds, *fds = NULL;
 	jag_prec_t *prec = NULL;
+	int len;
 
 	if (no_share_data == -1) {
 		char *acct_params = slurm_get_jobacct_gather_params();
@@ -471,71 +616,185 @@ static void _handle_stats(List prec_list, char *proc_stat_file, char *proc_io_fi
 		else
 			use_pss = 0;
 		xfree(acct_params);
+
+		have_smaps_rollup = !access("/proc/self/smaps_rollup", R_OK);
 	}
 
-	if (!(stat_fp = fopen(proc_stat_file, "r")))
-		return;  /* Assume the process went away */
 	/*
-	 * Close the file on exec() of user tasks.
-	 *
-	 * NOTE: If we fork() slurmstepd after the
-	 * fopen() above and before the fcntl() below,
-	 * then the user task may have this extra file
-	 * open, which can cause problems for
-	 * checkpoint/restart, but this should be a very rare
-	 * problem in practice.
+	 * Descriptors of the processes in a proctrack container are kept
+	 * open between polls and re-read, pgid mode walks all of /proc so
+	 * files are opened for the duration of this poll only.
 	 */
-	fd = fileno(stat_fp);
-	if (fcntl(fd, F_SETFD, FD_CLOEXEC) == -1)
-		error("%s: fcntl(%s): %m", __func__, proc_stat_file);
+	if (keep_fds)
+		fds = _find_proc_fds(pid);
+	if (!fds) {
+		if (keep_fds) {
+			fds = _add_proc_fds(pid);
+		} else {
+			fds = &local_fds;
+			memset(fds, 0, sizeof(jag_proc_fds_t));
+			fds->pid = pid;
+		}
+		fds->stat_fd = fds->statm_fd = fds->io_fd = fds->smaps_fd = -1;
+		if (_open_proc_fds(fds) != SLURM_SUCCESS)
+			goto cleanup;
+	}
+	fds->poll_id = poll_id;
 
-	prec = try_xmalloc(sizeof(jag_prec_t));
-	if (prec == NULL) {	/* Avoid killing slurmstepd on malloc failure */
-		fclose(stat_fp);
+	/* Threads never become processes, don't bother reading them again */
+	if (fds->is_lwp == 1)
 		return;
+
+	if ((len = _read_proc_fd(fds->stat_fd)) <= 0)
+		goto cleanup;	/* Assume the process went away */
+
+	prec = try_xmalloc(sizeof(jag_prec_t));
+	if (prec == NULL)	/* Avoid killing slurmstepd on malloc failure */
+		goto cleanup;
+	if (!_get_process_data_line(len, prec)) {
+		xfree(prec);
+		goto cleanup;
 	}
-	if (!_get_process_data_line(fd, prec)) {
+
+	/* If current pid corresponds to a Light Weight Process (Thread POSIX) */
+	/* skip it, we will only account the original process (pid==tgid) */
+	if (fds->is_lwp == -1)
+		fds->is_lwp = (_is_a_lwp(prec->pid) > 0);
+	if (fds->is_lwp) {
 		xfree(prec);
-		fclose(stat_fp);
-		return;
+		goto cleanup;
 	}
-	fclose(stat_fp);
 
 	/* Remove shared data from rss */
-	if (no_share_data)
-		_remove_share_data(proc_stat_file, prec);
+	if (no_share_data && (fds->statm_fd >= 0))
+		_get_process_memory_line(_read_proc_fd(fds->statm_fd), prec);
 
 	/* Use PSS instead if RSS */
 	if (use_pss) {
-		if (_get_pss(proc_smaps_file, prec) == -1) {
+		if ((fds->smaps_fd < 0) ||
+		    (_get_pss(fds->smaps_fd, prec) == -1)) {
 			xfree(prec);
-			return;
+			goto cleanup;
 		}
 	}
 
 	list_append(prec_list, prec);
 
-	if ((io_fp = fopen(proc_io_file, "r"))) {
-		fd2 = fileno(io_fp);
-		if (fcntl(fd2, F_SETFD, FD_CLOEXEC) == -1)
-			error("%s: fcntl: %m", __func__);
-		_get_process_io_data_line(fd2, prec);
-		fclose(io_fp);
+	if (fds->io_fd >= 0)
+		_get_process_io_data_line(_read_proc_fd(fds->io_fd), prec);
+	if (callbacks->prec_extra)
+		(*(callbacks->prec_extra))(prec);
+
+	if (!keep_fds)
+		_close_proc_fds(fds);
+	return;
+
+cleanup:
+	/* The process is gone, stale descriptors are dropped at poll end */
+	if (keep_fds)
+		fds->poll_id = poll_id - 1;
+	else
+		_close_proc_fds(fds);
+}
+
+static int _cmp_prec_pid(const void *x, const void *y)
+{
+	pid_t pid1 = ((jag_prec_t *) x)->pid;
+	pid_t pid2 = ((jag_prec_t *) y)->pid;
+
+	if (pid1 < pid2)
+		return -1;
+	return (pid1 > pid2);
+}
+
+/*
+ * Map the last node sample published by the slurmd.
+ * IN freq - poll frequency of the step, older samples are not used
+ * OUT size - size of the mapping, to be passed to munmap()
+ * RET the sample or NULL if there is none, or it is too old to be used
+ */
+static jag_node_sample_t *_map_node_sample(char *file_name, uint16_t freq,
+					   size_t *size)
+{
+	jag_node_sample_t *sample;
+	struct stat stat_buf;
+	int fd;
+
+	if ((fd = open(file_name, O_RDONLY | O_CLOEXEC)) < 0)
+		return NULL;
+	if ((fstat(fd, &stat_buf) < 0) ||
+	    (stat_buf.st_size < sizeof(jag_node_sample_t))) {
+		close(fd);
+		return NULL;
+	}
+	*size = stat_buf.st_size;
+	sample = mmap(NULL, *size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (sample == MAP_FAILED)
+		return NULL;
+
+	if ((sample->magic != JAG_NODE_SAMPLE_MAGIC) ||
+	    (sample->rec_size != sizeof(jag_prec_t)) ||
+	    (*size < (sizeof(jag_node_sample_t) +
+		      (size_t) sample->rec_cnt * sizeof(jag_prec_t))) ||
+	    ((time(NULL) - sample->sample_time) >= freq)) {
+		debug3("%s: ignoring stale or invalid %s", __func__, file_name);
+		munmap(sample, *size);
+		return NULL;
 	}
+
+	return sample;
+}
+
+/* Look up pid in the node sample */
+static jag_prec_t *_find_sample_rec(jag_node_sample_t *sample, pid_t pid)
+{
+	jag_prec_t key;
+
+	key.pid = pid;
+	return bsearch(&key, sample + 1, sample->rec_cnt, sizeof(jag_prec_t),
+		       _cmp_prec_pid);
+}
+
+/* Add a copy of a record of the node sample to prec_list */
+static void _add_sample_prec(List prec_list, jag_prec_t *rec,
+			     jag_callbacks_t *callbacks)
+{
+	jag_prec_t *prec;
+
+	prec = try_xmalloc(sizeof(jag_prec_t));
+	if (prec == NULL)	/* Avoid killing slurmstepd on malloc failure */
+		return;
+	memcpy(prec, rec, sizeof(jag_prec_t));
+	list_append(prec_list, prec);
 	if (callbacks->prec_extra)
 		(*(callbacks->prec_extra))(prec);
 }
 
+/*
+ * Build the list of processes to account for the step
+ * IN freq - poll frequency of the step, 0 to always read /proc
+ */
 static List _get_precs(List task_list, bool pgid_plugin, uint64_t cont_id,
-		       jag_callbacks_t *callbacks)
+		       uint16_t freq, jag_callbacks_t *callbacks)
 {
 	List prec_list = list_create(destroy_jag_prec);
-	char	proc_stat_file[256];	/* Allow ~20x extra length */
-	char	proc_io_file[256];	/* Allow ~20x extra length */
-	char	proc_smaps_file[256];	/* Allow ~20x extra length */
 	static	int	slash_proc_open = 0;
+	jag_node_sample_t *sample = NULL;
+	size_t sample_size = 0;
+	char *sample_file;
 	int i;
 
+	poll_id++;
+
+	/*
+	 * Use the processes sampled by the slurmd when it publishes them,
+	 * /proc is only read for the ones started since the last sample. A
+	 * sample taken before the previous poll of the step would be stale.
+	 */
+	if (freq && (sample_file = jobacct_gather_get_node_sample_file()))
+		sample = _map_node_sample(sample_file, freq, &sample_size);
+
 	if (!pgid_plugin) {
 		pid_t *pids = NULL;
 		int npids = 0;
@@ -556,16 +815,23 @@ static List _get_precs(List task_list, bool pgid_plugin, uint64_t cont_id,
 			goto finished;
 		}
 		for (i = 0; i < npids; i++) {
-			snprintf(proc_stat_file, 256, "/proc/%d/stat", pids[i]);
-			snprintf(proc_io_file, 256, "/proc/%d/io", pids[i]);
-			snprintf(proc_smaps_file, 256, "/proc/%d/smaps", pids[i]);
-			_handle_stats(prec_list, proc_stat_file, proc_io_file,
-				      proc_smaps_file, callbacks);
+			jag_prec_t *rec;
+			if (sample && (rec = _find_sample_rec(sample, pids[i])))
+				_add_sample_prec(prec_list, rec, callbacks);
+			else
+				_handle_stats(prec_list, pids[i], true,
+					      callbacks);
 		}
 		xfree(pids);
+	} else if (sample) {
+		jag_prec_t *rec = (jag_prec_t *) (sample + 1);
+
+		for (i = 0; i < sample->rec_cnt; i++)
+			_add_sample_prec(prec_list, &rec[i], callbacks);
 	} else {
 		struct dirent *slash_proc_entry;
-		char  *iptr = NULL, *optr = NULL, *optr2 = NULL;
+		char *iptr;
+		pid_t pid;
 
 		if (slash_proc_open) {
 			rewinddir(slash_proc);
@@ -577,83 +843,33 @@ static List _get_precs(List task_list, bool pgid_plugin, uint64_t cont_id,
 			}
 			slash_proc_open=1;
 		}
-		strcpy(proc_stat_file, "/proc/");
-		strcpy(proc_io_file, "/proc/");
-		strcpy(proc_smaps_file, "/proc/");
 
 		while ((slash_proc_entry = readdir(slash_proc))) {
-
-			/* Save a few cyles by simulating
-			 * strcat(statFileName, slash_proc_entry->d_name);
-			 * strcat(statFileName, "/stat");
-			 * while checking for a numeric filename (which really
-			 * should be a pid). Then do the same for the
-			 * /proc/<pid>/io file name.
-			 */
-			optr = proc_stat_file + sizeof("/proc");
-			iptr = slash_proc_entry->d_name;
-			i = 0;
-			do {
-				if ((*iptr < '0') ||
-				    ((*optr++ = *iptr++) > '9')) {
-					i = -1;
-					break;
-				}
-			} while (*iptr);
-
-			if (i == -1)
-				continue;
-			iptr = (char*)"/stat";
-
-			do {
-				*optr++ = *iptr++;
-			} while (*iptr);
-			*optr = 0;
-
-			optr2 = proc_io_file + sizeof("/proc");
+			/* Only numeric file names (which really should be
+			 * pids) are of interest */
 			iptr = slash_proc_entry->d_name;
-			i = 0;
+			pid = 0;
 			do {
-				if ((*iptr < '0') ||
-				    ((*optr2++ = *iptr++) > '9')) {
-					i = -1;
+				if ((*iptr < '0') || (*iptr > '9')) {
+					pid = -1;
 					break;
 				}
+				pid = (pid * 10) + (*iptr++ - '0');
 			} while (*iptr);
-			if (i == -1)
-				continue;
-			iptr = (char*)"/io";
-
-			do {
-				*optr2++ = *iptr++;
-			} while (*iptr);
-			*optr2 = 0;
 
-			optr2 = proc_smaps_file + sizeof("/proc");
-			iptr = slash_proc_entry->d_name;
-			i = 0;
-			do {
-				if ((*iptr < '0') ||
-				    ((*optr2++ = *iptr++) > '9')) {
-					i = -1;
-					break;
-				}
-			} while (*iptr);
-			if (i == -1)
+			if (pid <= 0)
 				continue;
-			iptr = (char*)"/smaps";
 
-			do {
-				*optr2++ = *iptr++;
-			} while (*iptr);
-			*optr2 = 0;
-
-			_handle_stats(prec_list, proc_stat_file, proc_io_file,
-				      proc_smaps_file,callbacks);
+			_handle_stats(prec_list, pid, false, callbacks);
 		}
 	}
 
 finished:
+	if (sample)
+		munmap(sample, sample_size);
+
+	/* Close the descriptors of processes which have gone away */
+	_purge_proc_fds();
 
 	return prec_list;
 }
@@ -783,6 +999,12 @@ extern void jag_common_fini(void)
 {
 	if (slash_proc)
 		(void) closedir(slash_proc);
+	poll_id++;
+	_purge_proc_fds();
+	xfree(proc_fds);
+	proc_fds_size = 0;
+	xfree(proc_buf);
+	proc_buf_size = 0;
 }
 
 extern void destroy_jag_prec(void *object)
@@ -805,6 +1027,13 @@ extern void print_jag_prec(jag_prec_t *prec)
 	info("vsize\t%"PRIu64"", prec->vsize);
 }
 
+extern List jag_common_get_precs(List task_list, bool pgid_plugin,
+				 uint64_t cont_id, jag_callbacks_t *callbacks)
+{
+	return _get_precs(task_list, pgid_plugin, cont_id,
+			  jobacct_gather_get_poll_freq(), callbacks);
+}
+
 extern void jag_common_poll_data(
 	List task_list, bool pgid_plugin, uint64_t cont_id,
 	jag_callbacks_t *callbacks, bool profile)
@@ -844,7 +1073,7 @@ extern void jag_common_poll_data(
 	}
 
 	if (!callbacks->get_precs)
-		callbacks->get_precs = _get_precs;
+		callbacks->get_precs = jag_common_get_precs;
 
 	ct = time(NULL);
 	prec_list = (*(callbacks->get_precs))(task_list, pgid_plugin, cont_id,
@@ -956,3 +1185,64 @@ finished:
 	FREE_NULL_LIST(prec_list);
 	processing = 0;
 }
+
+extern int jag_common_sample_node(char *file_name, uint16_t interval)
+{
+	static jag_callbacks_t callbacks;	/* No callbacks in the slurmd */
+	jag_node_sample_t sample;
+	jag_prec_t *recs = NULL, *prec;
+	ListIterator itr;
+	List prec_list;
+	char *tmp_name = NULL;
+	int fd = -1, i = 0, rc = SLURM_ERROR;
+
+	if (!my_pagesize)
+		my_pagesize = getpagesize() / 1024;
+
+	/* Collect without holding node_sample_lock, only publish under it */
+	prec_list = _get_precs(NULL, true, 0, 0, &callbacks);
+
+	memset(&sample, 0, sizeof(jag_node_sample_t));
+	sample.magic = JAG_NODE_SAMPLE_MAGIC;
+	sample.rec_size = sizeof(jag_prec_t);
+	sample.rec_cnt = list_count(prec_list);
+	sample.interval = interval;
+	sample.sample_time = time(NULL);
+
+	recs = xmalloc(sizeof(jag_prec_t) * MAX(sample.rec_cnt, 1));
+	itr = list_iterator_create(prec_list);
+	while ((prec = list_next(itr)))
+		memcpy(&recs[i++], prec, sizeof(jag_prec_t));
+	list_iterator_destroy(itr);
+	FREE_NULL_LIST(prec_list);
+	qsort(recs, sample.rec_cnt, sizeof(jag_prec_t), _cmp_prec_pid);
+
+	/* Readers must never see a partially written sample */
+	slurm_mutex_lock(&node_sample_lock);
+	xstrfmtcat(tmp_name, "%s.new", file_name);
+	if ((fd = open(tmp_name, O_CREAT | O_TRUNC | O_WRONLY | O_CLOEXEC,
+		       0600)) < 0) {
+		error("%s: Can't create %s: %m", __func__, tmp_name);
+		goto fini;
+	}
+	safe_write(fd, &sample, sizeof(jag_node_sample_t));
+	safe_write(fd, recs, sizeof(jag_prec_t) * sample.rec_cnt);
+	if (rename(tmp_name, file_name) < 0) {
+		error("%s: Can't rename %s to %s: %m",
+		      __func__, tmp_name, file_name);
+		goto rwfail;
+	}
+	rc = SLURM_SUCCESS;
+	goto fini;
+
+rwfail:
+	(void) unlink(tmp_name);
+fini:
+	if (fd >= 0)
+		(void) close(fd);
+	slurm_mutex_unlock(&node_sample_lock);
+	xfree(tmp_name);
+	xfree(recs);
+
+	return rc;
+}
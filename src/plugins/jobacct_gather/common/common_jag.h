@@ -41,6 +41,8 @@
 #ifndef __COMMON_JAG_H__
 #define __COMMON_JAG_H__
 
+#include <time.h>
+
 #include "src/common/list.h"
 
 typedef struct jag_prec {	/* process record */
@@ -57,6 +59,20 @@ typedef struct jag_prec {	/* process record */
 	uint64_t vsize;	/* virtual size */
 } jag_prec_t;
 
+/*
+ * Header of the file through which the slurmd publishes a node wide sample
+ * of /proc for the slurmstepds to read, it is followed by rec_cnt
+ * jag_prec_t sorted by pid.
+ */
+#define JAG_NODE_SAMPLE_MAGIC 0x4a414753
+typedef struct jag_node_sample {
+	uint32_t magic;
+	uint32_t rec_size;	/* sizeof(jag_prec_t) of the writer */
+	uint32_t rec_cnt;	/* count of records following the header */
+	uint32_t interval;	/* seconds between two samples */
+	time_t	sample_time;
+} jag_node_sample_t;
+
 typedef struct jag_callbacks {
 	void (*prec_extra) (jag_prec_t *prec);
 	List (*get_precs) (List task_list, bool pgid_plugin, uint64_t cont_id,
@@ -70,8 +86,20 @@ extern void jag_common_fini(void);
 extern void destroy_jag_prec(void *object);
 extern void print_jag_prec(jag_prec_t *prec);
 
+/* Build the list of jag_prec_t of the step processes from /proc */
+extern List jag_common_get_precs(List task_list, bool pgid_plugin,
+				 uint64_t cont_id, jag_callbacks_t *callbacks);
+
 extern void jag_common_poll_data(
 	List task_list, bool pgid_plugin, uint64_t cont_id,
 	jag_callbacks_t *callbacks, bool profile);
 
+/*
+ * Sample all the processes of the node and publish the result in file_name
+ * for the slurmstepds to use instead of walking /proc themselves.
+ * IN file_name - file to (atomically) replace with the new sample
+ * IN interval - seconds until the next sample is published
+ */
+extern int jag_common_sample_node(char *file_name, uint16_t interval);
+
 #endif
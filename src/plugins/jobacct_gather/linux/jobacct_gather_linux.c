@@ -214,3 +214,12 @@ extern int jobacct_gather_p_add_task(pid_t pid, jobacct_id_t *jobacct_id)
 {
 	return SLURM_SUCCESS;
 }
+
+/*
+ * jobacct_gather_p_sample_node() - Publish a sample of all the processes of
+ * the node, see jag_common_sample_node().
+ */
+extern int jobacct_gather_p_sample_node(char *file_name, uint16_t interval)
+{
+	return jag_common_sample_node(file_name, interval);
+}
@@ -162,6 +162,11 @@ extern int jobacct_gather_p_add_task(pid_t pid, jobacct_id_t *jobacct_id)
 	return SLURM_SUCCESS;
 }
 
+extern int jobacct_gather_p_sample_node(char *file_name, uint16_t interval)
+{
+	return SLURM_SUCCESS;
+}
+
 
 extern jobacctinfo_t *jobacct_gather_p_stat_task(pid_t pid)
 {
@@ -41,6 +41,7 @@
 
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "fair_tree.h"
 
@@ -67,9 +68,7 @@ extern void fair_tree_decay(List jobs, time_t start)
 	assoc_mgr_unlock(&locks);
 
 	/* assign job priorities */
-	lock_slurmctld(job_write_lock);
-	list_for_each(jobs, (ListForF) decay_apply_weighted_factors, &start);
-	unlock_slurmctld(job_write_lock);
+	decay_apply_weighted_factors_all(jobs, start, NULL, 0);
 }
 
 
@@ -175,9 +174,6 @@ static void _calc_assoc_fs(slurmdb_assoc_rec_t *assoc)
 
 	_ft_set_assoc_usage_efctv(assoc);
 
-	/* Fair Tree doesn't use usage_norm but we will set it anyway */
-	set_assoc_usage_norm(assoc);
-
 	U = assoc->usage->usage_efctv;
 	S = assoc->usage->shares_norm;
 
@@ -260,6 +256,46 @@ static size_t _count_tied_accounts(slurmdb_assoc_rec_t** assocs,
 }
 
 
+/* Return the children of an association sorted by level_fs.
+ *
+ * The sorted array is kept in assoc->usage->fs_children. A uniform decay
+ * scales usage_raw of a parent and of its children alike, so the level_fs
+ * of the children only changes when usage is added under the parent or
+ * shares change, both of which flag the parent with fs_dirty. Only then
+ * are the children's level_fs recalculated and the array sorted again.
+ * IN assoc - parent association
+ * RET - NULL terminated array, owned by assoc->usage. Do not free.
+ */
+static slurmdb_assoc_rec_t** _get_sorted_children(slurmdb_assoc_rec_t *assoc)
+{
+	slurmdb_assoc_usage_t *usage = assoc->usage;
+	size_t i, child_count = 0;
+
+	if (usage->fs_children && !usage->fs_dirty)
+		return usage->fs_children;
+
+	xfree(usage->fs_children);
+	if (usage->children_list) {
+		usage->fs_children = _append_list_to_array(
+			usage->children_list, NULL, &child_count);
+	} else {
+		usage->fs_children = (slurmdb_assoc_rec_t **)
+			xmalloc(sizeof(slurmdb_assoc_rec_t *));
+	}
+
+	/* Calculate level_fs for each child */
+	for (i = 0; i < child_count; i++)
+		_calc_assoc_fs(usage->fs_children[i]);
+
+	/* Sort children by level_fs */
+	qsort(usage->fs_children, child_count,
+	      sizeof(slurmdb_assoc_rec_t *), _cmp_level_fs);
+
+	usage->fs_dirty = false;
+
+	return usage->fs_children;
+}
+
 /* Copy the children of accounts [begin, end] into a single array.
  * IN siblings - array of siblings, sorted by level_fs
  * IN begin - index of first account to merge
@@ -280,24 +316,36 @@ static slurmdb_assoc_rec_t** _merge_accounts(
 	merged[0] = NULL;
 
 	for (i = begin; i <= end; i++) {
-		List children = siblings[i]->usage->children_list;
+		slurmdb_assoc_rec_t** children;
+		size_t child_count;
 
 		/* the first account's debug was already printed */
 		if (priority_debug && i > begin)
 			_ft_debug(siblings[i], assoc_level, true);
 
-		if (!children || list_is_empty(children)) {
+		children = _get_sorted_children(siblings[i]);
+		for (child_count = 0; children[child_count]; child_count++)
+			;
+		if (!child_count)
 			continue;
-		}
 
-		merged = _append_list_to_array(children, merged, &merged_size);
+		merged = xrealloc(merged, sizeof(slurmdb_assoc_rec_t *) *
+				  (merged_size + child_count + 1));
+		memcpy(merged + merged_size, children,
+		       sizeof(slurmdb_assoc_rec_t *) * child_count);
+		merged_size += child_count;
+		merged[merged_size] = NULL;
 	}
+
+	/* Sort the merged children by level_fs */
+	qsort(merged, merged_size, sizeof(slurmdb_assoc_rec_t *),
+	      _cmp_level_fs);
+
 	return merged;
 }
 
 
-/* Calculate fairshare for each child then sort children by fairshare value
- * (level_fs). Once they are sorted, operate on each child in sorted order.
+/* Operate on each child in sorted order (see _get_sorted_children()).
  * This portion of the tree is now sorted and users are given a fairshare value
  * based on the order they are operated on. The basic equation is
  * (rank / g_user_assoc_count), though ties are allowed. The rank is
@@ -325,16 +373,14 @@ static void _calc_tree_fs(slurmdb_assoc_rec_t** siblings,
 	bool tied = false;
 	size_t i;
 
-	/* Calculate level_fs for each child */
-	for (i = 0; (assoc = siblings[i]); i++)
-		_calc_assoc_fs(assoc);
-
-	/* Sort children by level_fs */
-	qsort(siblings, i, sizeof(slurmdb_assoc_rec_t *), _cmp_level_fs);
-
 	/* Iterate through children in sorted order. If it's a user, calculate
 	 * fs_factor, otherwise recurse. */
 	for (i = 0; (assoc = siblings[i]); i++) {
+		/* Fair Tree doesn't use usage_norm but we will set it anyway.
+		 * The root usage changes every cycle, so this is done even
+		 * for levels which were not sorted again. */
+		set_assoc_usage_norm(assoc);
+
 		/* tied is used while iterating across siblings.
 		 * account_tied preserves ties while recursing */
 		if (i == 0 && account_tied) {
@@ -363,6 +409,14 @@ static void _calc_tree_fs(slurmdb_assoc_rec_t** siblings,
 			slurmdb_assoc_rec_t** children;
 			size_t merge_count = _count_tied_accounts(siblings, i);
 
+			if (!merge_count) {
+				children = _get_sorted_children(assoc);
+				_calc_tree_fs(children, assoc_level+1,
+					      rank, rnt, tied);
+				prev_level_fs = assoc->usage->level_fs;
+				continue;
+			}
+
 			/* Merging does not affect child level_fs calculations
 			 * since the necessary information is stored on each
 			 * assoc's usage struct */
@@ -390,7 +444,6 @@ static void _apply_priority_fs(void)
 	slurmdb_assoc_rec_t** children = NULL;
 	uint32_t rank = g_user_assoc_count;
 	uint32_t rnt = rank;
-	size_t child_count = 0;
 
 	if (priority_debug)
 		info("Fair Tree fairshare algorithm, starting at root:");
@@ -398,12 +451,7 @@ static void _apply_priority_fs(void)
 	assoc_mgr_root_assoc->usage->level_fs = (long double) NO_VAL;
 
 	/* _calc_tree_fs requires an array instead of List */
-	children = _append_list_to_array(
-		assoc_mgr_root_assoc->usage->children_list,
-		children,
-		&child_count);
+	children = _get_sorted_children(assoc_mgr_root_assoc);
 
 	_calc_tree_fs(children, 0, &rank, &rnt, false);
-
-	xfree(children);
 }
@@ -242,6 +242,7 @@ static int _reset_usage(void)
 		assoc->usage->grp_used_wall = 0;
 	}
 	list_iterator_destroy(itr);
+	assoc_mgr_set_fs_dirty(NULL);
 
 	itr = list_iterator_create(assoc_mgr_qos_list);
 	while ((qos = list_next(itr))) {
@@ -432,23 +433,16 @@ static int _set_children_usage_efctv(List children_list)
 /* job_ptr should already have the partition priority and such added here
  * before had we will be adding to it
  */
-static double _get_fairshare_priority(struct job_record *job_ptr)
+/* Fairshare factor of job, the caller must hold the assoc read lock */
+static double _get_fairshare_priority_locked(struct job_record *job_ptr)
 {
 	slurmdb_assoc_rec_t *job_assoc;
 	slurmdb_assoc_rec_t *fs_assoc = NULL;
 	double priority_fs = 0.0;
-	assoc_mgr_lock_t locks = { READ_LOCK, NO_LOCK, NO_LOCK, NO_LOCK,
-				   NO_LOCK, NO_LOCK, NO_LOCK };
-
-	if (!calc_fairshare)
-		return 0;
-
-	assoc_mgr_lock(&locks);
 
 	job_assoc = job_ptr->assoc_ptr;
 
 	if (!job_assoc) {
-		assoc_mgr_unlock(&locks);
 		error("Job %u has no association.  Unable to "
 		      "compute fairshare.", job_ptr->job_id);
 		return 0;
@@ -484,6 +478,21 @@ static double _get_fairshare_priority(struct job_record *job_ptr)
 			     fs_assoc->usage->shares_norm, priority_fs);
 		}
 	}
+
+	return priority_fs;
+}
+
+static double _get_fairshare_priority(struct job_record *job_ptr)
+{
+	double priority_fs;
+	assoc_mgr_lock_t locks = { READ_LOCK, NO_LOCK, NO_LOCK, NO_LOCK,
+				   NO_LOCK, NO_LOCK, NO_LOCK };
+
+	if (!calc_fairshare)
+		return 0;
+
+	assoc_mgr_lock(&locks);
+	priority_fs = _get_fairshare_priority_locked(job_ptr);
 	assoc_mgr_unlock(&locks);
 
 	return priority_fs;
@@ -1152,6 +1161,10 @@ static int _apply_new_usage(struct job_record *job_ptr,
 	}
 
 
+	/* Fair Tree only needs to revisit the levels above this assoc */
+	if (real_decay)
+		assoc_mgr_set_fs_dirty(assoc);
+
 	/* We want to do this all the way up
 	 * to and including root.  This way we
 	 * can keep track of how much usage
@@ -1178,21 +1191,65 @@ static int _apply_new_usage(struct job_record *job_ptr,
 }
 
 
-static int _decay_apply_new_usage_and_weighted_factors(
-	struct job_record *job_ptr,
-	time_t *start_time_ptr)
+/* Arguments of _decay_apply_new_usage() */
+typedef struct {
+	time_t *start_time_ptr;
+	uint32_t *skip_ids;	/* jobs whose new usage was not applied */
+	uint32_t skip_cnt;
+	uint32_t skip_size;
+} decay_usage_args_t;
+
+static int _cmp_job_id(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *) a, y = *(const uint32_t *) b;
+
+	if (x < y)
+		return -1;
+	return (x > y);
+}
+
+static int _decay_apply_new_usage(struct job_record *job_ptr,
+				  decay_usage_args_t *args)
 {
 	/* Always return SUCCESS so that list_for_each will
 	 * continue processing list of jobs. */
-
-	if (!decay_apply_new_usage(job_ptr, start_time_ptr))
+	if (decay_apply_new_usage(job_ptr, args->start_time_ptr))
 		return SLURM_SUCCESS;
 
-	decay_apply_weighted_factors(job_ptr, start_time_ptr);
+	/* Don't recalculate the priority of this job on this pass */
+	if (args->skip_cnt >= args->skip_size) {
+		args->skip_size = MAX(args->skip_size * 2, 64);
+		xrealloc(args->skip_ids, sizeof(uint32_t) * args->skip_size);
+	}
+	args->skip_ids[args->skip_cnt++] = job_ptr->job_id;
 
 	return SLURM_SUCCESS;
 }
 
+/* Apply new usage to all jobs, then recalculate the priority of the jobs
+ * it was applied to. Job write lock must not be held. */
+static void _decay_apply_all(time_t start_time)
+{
+	/* Write lock on jobs, read lock on nodes and partitions */
+	slurmctld_lock_t job_write_lock =
+		{ NO_LOCK, WRITE_LOCK, READ_LOCK, READ_LOCK, NO_LOCK };
+	decay_usage_args_t args;
+
+	memset(&args, 0, sizeof(decay_usage_args_t));
+	args.start_time_ptr = &start_time;
+
+	lock_slurmctld(job_write_lock);
+	list_for_each(job_list, (ListForF) _decay_apply_new_usage, &args);
+	unlock_slurmctld(job_write_lock);
+
+	if (args.skip_cnt > 1)
+		qsort(args.skip_ids, args.skip_cnt, sizeof(uint32_t),
+		      _cmp_job_id);
+	decay_apply_weighted_factors_all(job_list, start_time,
+					 args.skip_ids, args.skip_cnt);
+	xfree(args.skip_ids);
+}
+
 
 static void *_decay_thread(void *no_data)
 {
@@ -1206,9 +1263,6 @@ static void *_decay_thread(void *no_data)
 	double run_delta = 0.0, real_decay = 0.0;
 	double elapsed;
 
-	/* Write lock on jobs, read lock on nodes and partitions */
-	slurmctld_lock_t job_write_lock =
-		{ NO_LOCK, WRITE_LOCK, READ_LOCK, READ_LOCK, NO_LOCK };
 	assoc_mgr_lock_t locks = { WRITE_LOCK, NO_LOCK, NO_LOCK, NO_LOCK,
 				   NO_LOCK, NO_LOCK, NO_LOCK };
 
@@ -1356,15 +1410,8 @@ static void *_decay_thread(void *no_data)
 			break;
 		}
 
-		if (!(flags & PRIORITY_FLAGS_FAIR_TREE)) {
-			lock_slurmctld(job_write_lock);
-			list_for_each(
-				job_list,
-				(ListForF) _decay_apply_new_usage_and_weighted_factors,
-				&start_time
-				);
-			unlock_slurmctld(job_write_lock);
-		}
+		if (!(flags & PRIORITY_FLAGS_FAIR_TREE))
+			_decay_apply_all(start_time);
 
 	get_usage:
 		if (flags & PRIORITY_FLAGS_FAIR_TREE)
@@ -1703,9 +1750,6 @@ static void _set_usage_efctv(slurmdb_assoc_rec_t *assoc)
 int init ( void )
 {
 	char *temp = NULL;
-	/* Write lock on jobs, read lock on nodes and partitions */
-	slurmctld_lock_t job_write_lock =
-		{ NO_LOCK, WRITE_LOCK, READ_LOCK, READ_LOCK, NO_LOCK };
 
 	/* This means we aren't running from the controller so skip setup. */
 	if (cluster_cpus == NO_VAL) {
@@ -1732,12 +1776,7 @@ int init ( void )
 		weight_fs = 0;
 
 		/* Initialize job priority factors for valid sprio output */
-		lock_slurmctld(job_write_lock);
-		list_for_each(
-			job_list,
-			(ListForF) _decay_apply_new_usage_and_weighted_factors,
-			&start_time);
-		unlock_slurmctld(job_write_lock);
+		_decay_apply_all(start_time);
 	} else if (assoc_mgr_root_assoc) {
 		if (!cluster_cpus)
 			fatal("We need to have a cluster cpu count "
@@ -1828,6 +1867,7 @@ extern void priority_p_reconfig(bool assoc_clear)
 	    (prevflags & PRIORITY_FLAGS_FAIR_TREE)) {
 		assoc_mgr_lock(&locks);
 		_set_norm_shares(assoc_mgr_root_assoc->usage->children_list);
+		assoc_mgr_set_fs_dirty(NULL);
 		assoc_mgr_unlock(&locks);
 	}
 
@@ -2041,6 +2081,445 @@ extern int decay_apply_weighted_factors(struct job_record *job_ptr,
 }
 
 
+/*
+ * Priority inputs of the job queue laid out as parallel arrays. They are
+ * gathered under the job read lock, the weighted factors of every job are
+ * then computed in a few flat loops without any lock held and only the
+ * results are written back to the job records under the job write lock.
+ */
+typedef struct {
+	uint32_t job_cnt;
+	struct job_record **job_ptr;
+	uint32_t *job_id;
+	bool *per_job;		/* use decay_apply_weighted_factors() */
+	double *age;		/* seconds accrued, -1 if not accruing */
+	double *fs;
+	double *js;
+	double *js_cpus;
+	double *js_nodes;
+	double *js_time;	/* time limit for PRIORITY_FLAGS_SIZE_RELATIVE */
+	double *part;
+	double *qos;
+	double *nice;		/* nice - NICE_OFFSET */
+	double *tres;		/* job_cnt rows of tres_cnt factors */
+	double *tres_sum;
+	double *prio;
+
+	/* Configuration, copied under the lock as reconfig may change it */
+	uint32_t flags;
+	bool favor_small;
+	double max_age;
+	double cluster_cpus;
+	double node_cnt;
+	double w_age, w_fs, w_js, w_part, w_qos;
+	int tres_cnt;
+	double *w_tres;
+} prio_calc_t;
+
+static void _prio_calc_free(prio_calc_t *calc)
+{
+	xfree(calc->job_ptr);
+	xfree(calc->job_id);
+	xfree(calc->per_job);
+	xfree(calc->age);
+	xfree(calc->fs);
+	xfree(calc->js);
+	xfree(calc->js_cpus);
+	xfree(calc->js_nodes);
+	xfree(calc->js_time);
+	xfree(calc->part);
+	xfree(calc->qos);
+	xfree(calc->nice);
+	xfree(calc->tres);
+	xfree(calc->tres_sum);
+	xfree(calc->prio);
+	xfree(calc->w_tres);
+}
+
+/* Same tests as decay_apply_weighted_factors(), plus finished jobs */
+static bool _prio_calc_wanted(struct job_record *job_ptr)
+{
+	if (IS_JOB_FINISHED(job_ptr) || IS_JOB_COMPLETING(job_ptr))
+		return false;
+	if ((job_ptr->priority == 0) ||
+	    IS_JOB_POWER_UP_NODE(job_ptr) ||
+	    (!IS_JOB_PENDING(job_ptr) &&
+	     !(flags & PRIORITY_FLAGS_CALCULATE_RUNNING)))
+		return false;
+	return true;
+}
+
+/* Test if job_ptr is in the sorted skip_ids array */
+static bool _skip_job(struct job_record *job_ptr, uint32_t *skip_ids,
+		      uint32_t skip_cnt)
+{
+	if (!skip_cnt)
+		return false;
+	return bsearch(&job_ptr->job_id, skip_ids, skip_cnt, sizeof(uint32_t),
+		       _cmp_job_id) != NULL;
+}
+
+/* Copy the raw factors of job into row i, mirrors set_priority_factors() */
+static void _prio_calc_set_inputs(prio_calc_t *calc, uint32_t i,
+				  struct job_record *job_ptr,
+				  time_t start_time)
+{
+	struct job_details *details = job_ptr->details;
+	slurmdb_qos_rec_t *qos_ptr = job_ptr->qos_ptr;
+	int t;
+
+	if (calc->w_age) {
+		time_t use_time;
+
+		if (calc->flags & PRIORITY_FLAGS_ACCRUE_ALWAYS)
+			use_time = details->submit_time;
+		else
+			use_time = details->begin_time;
+
+		if (!details->begin_time &&
+		    !(calc->flags & PRIORITY_FLAGS_ACCRUE_ALWAYS))
+			calc->age[i] = -1;
+		else if (start_time > use_time)
+			calc->age[i] = (double)(start_time - use_time);
+	}
+
+	if (job_ptr->assoc_ptr && calc->w_fs && calc_fairshare)
+		calc->fs[i] = _get_fairshare_priority_locked(job_ptr);
+
+	if (calc->w_js) {
+		uint32_t cpu_cnt = 0;
+
+		if (job_ptr->total_cpus)
+			cpu_cnt = job_ptr->total_cpus;
+		else if (details->max_cpus != NO_VAL)
+			cpu_cnt = details->max_cpus;
+		else if (details->min_cpus)
+			cpu_cnt = details->min_cpus;
+		calc->js_cpus[i] = (double)cpu_cnt;
+		calc->js_nodes[i] = (double)details->min_nodes;
+		if (job_ptr->time_limit != NO_VAL)
+			calc->js_time[i] = (double)job_ptr->time_limit;
+		else if (job_ptr->part_ptr)
+			calc->js_time[i] = (double)job_ptr->part_ptr->max_time;
+		else
+			calc->js_time[i] = 1.0;
+	}
+
+	if (job_ptr->part_ptr && job_ptr->part_ptr->priority_job_factor &&
+	    calc->w_part)
+		calc->part[i] = job_ptr->part_ptr->norm_priority;
+
+	if (qos_ptr && qos_ptr->priority && calc->w_qos)
+		calc->qos[i] = qos_ptr->usage->norm_priority;
+
+	calc->nice[i] = (double)(((int64_t)details->nice) - NICE_OFFSET);
+
+	for (t = 0; t < calc->tres_cnt; t++) {
+		uint64_t value = 0;
+
+		if (job_ptr->tres_alloc_cnt)
+			value = job_ptr->tres_alloc_cnt[t];
+		else if (job_ptr->tres_req_cnt)
+			value = job_ptr->tres_req_cnt[t];
+
+		if (value &&
+		    job_ptr->part_ptr &&
+		    job_ptr->part_ptr->tres_cnt &&
+		    job_ptr->part_ptr->tres_cnt[t])
+			calc->tres[i * calc->tres_cnt + t] = value /
+				(double)job_ptr->part_ptr->tres_cnt[t];
+	}
+}
+
+/* Snapshot the priority inputs of jobs, job read lock must be held */
+static void _prio_calc_gather(List jobs, time_t start_time,
+			      uint32_t *skip_ids, uint32_t skip_cnt,
+			      prio_calc_t *calc)
+{
+	struct job_record *job_ptr;
+	ListIterator itr;
+	uint32_t cnt, i = 0;
+	assoc_mgr_lock_t locks = { READ_LOCK, NO_LOCK, NO_LOCK, NO_LOCK,
+				   NO_LOCK, NO_LOCK, NO_LOCK };
+
+	calc->flags = flags;
+	calc->favor_small = favor_small;
+	calc->max_age = (double)max_age;
+	calc->cluster_cpus = (double)cluster_cpus;
+	calc->node_cnt = (double)node_record_count;
+	calc->w_age = (double)weight_age;
+	calc->w_fs = (double)weight_fs;
+	calc->w_js = (double)weight_js;
+	calc->w_part = (double)weight_part;
+	calc->w_qos = (double)weight_qos;
+	if (weight_tres) {
+		calc->tres_cnt = slurmctld_tres_cnt;
+		calc->w_tres = xmalloc(sizeof(double) * calc->tres_cnt);
+		memcpy(calc->w_tres, weight_tres,
+		       sizeof(double) * calc->tres_cnt);
+	}
+
+	if (!(cnt = list_count(jobs)))
+		return;
+	calc->job_ptr = xmalloc(sizeof(struct job_record *) * cnt);
+	calc->job_id = xmalloc(sizeof(uint32_t) * cnt);
+	calc->per_job = xmalloc(sizeof(bool) * cnt);
+	calc->age = xmalloc(sizeof(double) * cnt);
+	calc->fs = xmalloc(sizeof(double) * cnt);
+	calc->js = xmalloc(sizeof(double) * cnt);
+	calc->js_cpus = xmalloc(sizeof(double) * cnt);
+	calc->js_nodes = xmalloc(sizeof(double) * cnt);
+	calc->js_time = xmalloc(sizeof(double) * cnt);
+	calc->part = xmalloc(sizeof(double) * cnt);
+	calc->qos = xmalloc(sizeof(double) * cnt);
+	calc->nice = xmalloc(sizeof(double) * cnt);
+	calc->tres_sum = xmalloc(sizeof(double) * cnt);
+	calc->prio = xmalloc(sizeof(double) * cnt);
+	if (calc->tres_cnt)
+		calc->tres = xmalloc(sizeof(double) * cnt * calc->tres_cnt);
+
+	/* One assoc lock for the whole queue rather than one per job */
+	assoc_mgr_lock(&locks);
+	itr = list_iterator_create(jobs);
+	while ((job_ptr = list_next(itr))) {
+		if (!_prio_calc_wanted(job_ptr) ||
+		    _skip_job(job_ptr, skip_ids, skip_cnt))
+			continue;
+		calc->job_ptr[i] = job_ptr;
+		calc->job_id[i] = job_ptr->job_id;
+		if ((job_ptr->direct_set_prio && (job_ptr->priority > 0)) ||
+		    !job_ptr->details || job_ptr->part_ptr_list)
+			calc->per_job[i] = true;
+		else
+			_prio_calc_set_inputs(calc, i, job_ptr, start_time);
+		i++;
+	}
+	list_iterator_destroy(itr);
+	assoc_mgr_unlock(&locks);
+
+	calc->job_cnt = i;
+}
+
+/* Compute the weighted factors and priority of every gathered job */
+static void _prio_calc_run(prio_calc_t *calc)
+{
+	uint32_t i, n = calc->job_cnt;
+	int t;
+
+	for (i = 0; i < n; i++) {
+		double age = calc->age[i];
+
+		if (age < 0)
+			age = 0.0;
+		else if (age >= calc->max_age)
+			age = 1.0;
+		else
+			age /= calc->max_age;
+		calc->age[i] = age * calc->w_age;
+	}
+
+	for (i = 0; i < n; i++)
+		calc->fs[i] *= calc->w_fs;
+
+	if (calc->w_js && (calc->flags & PRIORITY_FLAGS_SIZE_RELATIVE)) {
+		for (i = 0; i < n; i++) {
+			double js = calc->js_nodes[i] * calc->cluster_cpus /
+				    calc->node_cnt;
+
+			if (calc->js_cpus[i] > js)
+				js = calc->js_cpus[i];
+			js /= calc->js_time[i];
+			js /= calc->cluster_cpus;
+			if (calc->favor_small)
+				js = 1.0 - js;
+			calc->js[i] = js;
+		}
+	} else if (calc->w_js && calc->favor_small) {
+		for (i = 0; i < n; i++) {
+			double js = (calc->node_cnt - calc->js_nodes[i]) /
+				    calc->node_cnt;
+
+			if (calc->js_cpus[i]) {
+				js += (calc->cluster_cpus - calc->js_cpus[i]) /
+				      calc->cluster_cpus;
+				js /= 2;
+			}
+			calc->js[i] = js;
+		}
+	} else if (calc->w_js) {
+		for (i = 0; i < n; i++) {
+			double js = calc->js_nodes[i] / calc->node_cnt;
+
+			if (calc->js_cpus[i]) {
+				js += calc->js_cpus[i] / calc->cluster_cpus;
+				js /= 2;
+			}
+			calc->js[i] = js;
+		}
+	}
+	for (i = 0; i < n; i++) {
+		double js = calc->js[i];
+
+		if (js < 0.0)
+			js = 0.0;
+		else if (js > 1.0)
+			js = 1.0;
+		calc->js[i] = js * calc->w_js;
+	}
+
+	for (i = 0; i < n; i++) {
+		calc->part[i] *= calc->w_part;
+		calc->qos[i] *= calc->w_qos;
+	}
+
+	for (i = 0; calc->tres_cnt && (i < n); i++) {
+		double *tres = calc->tres + (i * calc->tres_cnt);
+		double sum = 0.0;
+
+		for (t = 0; t < calc->tres_cnt; t++) {
+			tres[t] *= calc->w_tres[t];
+			sum += tres[t];
+		}
+		calc->tres_sum[i] = sum;
+	}
+
+	for (i = 0; i < n; i++) {
+		double prio = calc->age[i] + calc->fs[i] + calc->js[i] +
+			      calc->part[i] + calc->qos[i] +
+			      calc->tres_sum[i] - calc->nice[i];
+
+		/* Priority 0 is reserved for held jobs */
+		calc->prio[i] = (prio < 1) ? 1 : prio;
+	}
+}
+
+/* Store row i in the prio_factors of job_ptr */
+static void _prio_calc_set_factors(prio_calc_t *calc, uint32_t i,
+				   struct job_record *job_ptr)
+{
+	priority_factors_object_t *prio_factors;
+	size_t tres_size = sizeof(double) * calc->tres_cnt;
+
+	if (!job_ptr->prio_factors)
+		job_ptr->prio_factors =
+			xmalloc(sizeof(priority_factors_object_t));
+	prio_factors = job_ptr->prio_factors;
+
+	prio_factors->priority_age  = calc->age[i];
+	prio_factors->priority_fs   = calc->fs[i];
+	prio_factors->priority_js   = calc->js[i];
+	prio_factors->priority_part = calc->part[i];
+	prio_factors->priority_qos  = calc->qos[i];
+	prio_factors->nice = job_ptr->details->nice;
+
+	if (!calc->tres_cnt) {
+		xfree(prio_factors->priority_tres);
+		xfree(prio_factors->tres_weights);
+		prio_factors->tres_cnt = 0;
+		return;
+	}
+	if (!prio_factors->priority_tres ||
+	    (prio_factors->tres_cnt != calc->tres_cnt)) {
+		xfree(prio_factors->priority_tres);
+		xfree(prio_factors->tres_weights);
+		prio_factors->priority_tres = xmalloc(tres_size);
+		prio_factors->tres_weights = xmalloc(tres_size);
+		prio_factors->tres_cnt = calc->tres_cnt;
+	}
+	memcpy(prio_factors->priority_tres, calc->tres + (i * calc->tres_cnt),
+	       tres_size);
+	memcpy(prio_factors->tres_weights, calc->w_tres, tres_size);
+}
+
+/* Write the computed priorities back, job write lock must be held */
+static void _prio_calc_apply(prio_calc_t *calc, time_t start_time)
+{
+	struct job_record *job_ptr;
+	uint32_t i, new_prio;
+	double prio;
+	bool updated = false;
+
+	for (i = 0; i < calc->job_cnt; i++) {
+		/* The job may have been purged while the lock was released */
+		job_ptr = find_job_record(calc->job_id[i]);
+		if (!job_ptr || (job_ptr != calc->job_ptr[i]))
+			continue;
+
+		if (calc->per_job[i] || job_ptr->part_ptr_list ||
+		    job_ptr->direct_set_prio || !job_ptr->details) {
+			decay_apply_weighted_factors(job_ptr, &start_time);
+			continue;
+		}
+		if (!_prio_calc_wanted(job_ptr))
+			continue;
+
+		_prio_calc_set_factors(calc, i, job_ptr);
+
+		prio = calc->prio[i];
+		if (prio > (double)0xffffffff) {
+			error("Job %u priority exceeds 32 bits",
+			      job_ptr->job_id);
+			prio = (double)0xffffffff;
+		}
+		new_prio = (uint32_t)prio;
+		if (((flags & PRIORITY_FLAGS_INCR_ONLY) == 0) ||
+		    (job_ptr->priority < new_prio)) {
+			job_ptr->priority = new_prio;
+			updated = true;
+		}
+
+		debug2("priority for job %u is now %u",
+		       job_ptr->job_id, job_ptr->priority);
+	}
+
+	if (updated)
+		last_job_update = time(NULL);
+}
+
+extern void decay_apply_weighted_factors_all(List jobs, time_t start_time,
+					     uint32_t *skip_ids,
+					     uint32_t skip_cnt)
+{
+	/* Read lock on jobs, nodes and partitions */
+	slurmctld_lock_t job_read_lock =
+		{ NO_LOCK, READ_LOCK, READ_LOCK, READ_LOCK, NO_LOCK };
+	/* Write lock on jobs, read lock on nodes and partitions */
+	slurmctld_lock_t job_write_lock =
+		{ NO_LOCK, WRITE_LOCK, READ_LOCK, READ_LOCK, NO_LOCK };
+	struct job_record *job_ptr;
+	ListIterator itr;
+	prio_calc_t calc;
+
+	if (priority_debug) {
+		/* Keep the per job trace of every factor */
+		lock_slurmctld(job_write_lock);
+		itr = list_iterator_create(jobs);
+		while ((job_ptr = list_next(itr))) {
+			if (!_skip_job(job_ptr, skip_ids, skip_cnt))
+				decay_apply_weighted_factors(job_ptr,
+							     &start_time);
+		}
+		list_iterator_destroy(itr);
+		unlock_slurmctld(job_write_lock);
+		return;
+	}
+
+	memset(&calc, 0, sizeof(prio_calc_t));
+
+	lock_slurmctld(job_read_lock);
+	_prio_calc_gather(jobs, start_time, skip_ids, skip_cnt, &calc);
+	unlock_slurmctld(job_read_lock);
+
+	_prio_calc_run(&calc);
+
+	lock_slurmctld(job_write_lock);
+	_prio_calc_apply(&calc, start_time);
+	unlock_slurmctld(job_write_lock);
+
+	_prio_calc_free(&calc);
+}
+
+
 extern void set_priority_factors(time_t start_time, struct job_record *job_ptr)
 {
 	slurmdb_qos_rec_t *qos_ptr = NULL;
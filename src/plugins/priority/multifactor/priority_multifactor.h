@@ -57,6 +57,11 @@ extern bool decay_apply_new_usage(
 		struct job_record *job_ptr, time_t *start_time_ptr);
 extern int  decay_apply_weighted_factors(
 		struct job_record *job_ptr, time_t *start_time_ptr);
+/* Recalculate the priority of every job in jobs except the skip_cnt jobs
+ * whose IDs are in the sorted skip_ids array. Job locks must not be held. */
+extern void decay_apply_weighted_factors_all(List jobs, time_t start_time,
+					     uint32_t *skip_ids,
+					     uint32_t skip_cnt);
 extern void set_assoc_usage_norm(slurmdb_assoc_rec_t *assoc);
 extern void set_priority_factors(time_t start_time, struct job_record *job_ptr);
 
@@ -1093,6 +1093,7 @@ static int _attempt_backfill(void)
 	if (backfill_continue)
 		list_for_each(job_list, _clear_job_start_times, NULL);
 
+	acct_policy_cycle_begin();
 	gettimeofday(&bf_time1, NULL);
 
 	slurmctld_diag_stats.bf_queue_len = list_count(job_queue);
@@ -2292,6 +2293,7 @@ skip_start:
 	}
 	xfree(node_space);
 	FREE_NULL_LIST(job_queue);
+	acct_policy_cycle_end();
 
 	gettimeofday(&bf_time2, NULL);
 	_do_diag_stats(&bf_time1, &bf_time2);
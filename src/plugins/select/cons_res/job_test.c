@@ -93,6 +93,7 @@
 \*****************************************************************************/
 
 #include <inttypes.h>
+#include <string.h>
 #include <time.h>
 
 #include "dist_tasks.h"
@@ -153,6 +154,18 @@ static uint16_t *_select_nodes(struct job_record *job_ptr, uint32_t min_nodes,
 				bitstr_t *part_core_map,
 				bool prefer_alloc_nodes);
 static uint32_t _socks_per_node(struct job_record *job_ptr);
+static void _topo_cache_build(uint32_t cr_node_cnt);
+static void _topo_sum_cpus(bitstr_t *avail_bitmap, uint16_t *cpu_cnt,
+			   int *switches_cpu_cnt);
+
+/* Node to switch index, built from switch_record_table on first use after
+ * select_p_node_init(). The switches containing node i (its leaf switch and
+ * every higher level switch) are topo_node_sw[topo_node_sw_inx[i]] through
+ * topo_node_sw[topo_node_sw_inx[i + 1] - 1] */
+static int *topo_node_sw = NULL;
+static int *topo_node_sw_inx = NULL;
+static uint32_t topo_node_cnt = 0;
+static int topo_switch_cnt = 0;
 
 /* _allocate_sockets - Given the job requirements, determine which sockets
  *                     from the given node can be allocated (if any) to this
@@ -547,6 +560,23 @@ fini:
 	return cpu_count;
 }
 
+/* Return true if node_i has pn_min_memory (req_mem) available. Either with
+ * or without MEM_PER_CPU, a node with less than req_mem free can not run
+ * a single CPU of the job. */
+static bool _node_mem_avail(uint32_t node_i, uint64_t req_mem,
+			    struct node_use_record *node_usage, bool test_only)
+{
+	uint64_t avail_mem;
+
+	if (req_mem == 0)
+		return true;
+	avail_mem = select_node_record[node_i].real_memory -
+		    select_node_record[node_i].mem_spec_limit;
+	if (!test_only)
+		avail_mem -= node_usage[node_i].alloc_memory;
+	return (req_mem <= avail_mem);
+}
+
 /*
  * _can_job_run_on_node - Given the job requirements, determine which
  *                        resources from the given node (if any) can be
@@ -589,6 +619,14 @@ uint16_t _can_job_run_on_node(struct job_record *job_ptr, bitstr_t *core_map,
 
 	core_start_bit = cr_get_coremap_offset(node_i);
 	core_end_bit   = cr_get_coremap_offset(node_i+1) - 1;
+	if ((cr_type & CR_MEMORY) &&
+	    !_node_mem_avail(node_i, job_ptr->details->pn_min_memory &
+				     ~MEM_PER_CPU, node_usage, test_only)) {
+		/* Same result as the memory test below would reach, without
+		 * the GRES and core bitmap work */
+		bit_nclear(core_map, core_start_bit, core_end_bit);
+		return (uint16_t) 0;
+	}
 	cpus_per_core  = select_node_record[node_i].cpus /
 			 (core_end_bit - core_start_bit + 1);
 	node_ptr = select_node_record[node_i].node_ptr;
@@ -1178,11 +1216,13 @@ static void _get_res_usage(struct job_record *job_ptr, bitstr_t *node_map,
 			   bool test_only, bitstr_t *part_core_map)
 {
 	uint16_t *cpu_cnt;
-	uint32_t n;
 	uint32_t s_p_n = _socks_per_node(job_ptr);
+	int n, first, last;
 
 	cpu_cnt = xmalloc(cr_node_cnt * sizeof(uint16_t));
-	for (n = 0; n < cr_node_cnt; n++) {
+	first = bit_ffs(node_map);
+	last  = bit_fls(node_map);
+	for (n = first; ((n <= last) && (first >= 0)); n++) {
 		if (!bit_test(node_map, n))
 			continue;
 		cpu_cnt[n] = _can_job_run_on_node(job_ptr, core_map, n, s_p_n,
@@ -1999,6 +2039,84 @@ static int _eval_nodes_serial(struct job_record *job_ptr, bitstr_t *node_map,
 fini:	return error_code;
 }
 
+/* Free the node to switch index, it is rebuilt when next used */
+extern void cr_fini_topo_cache(void)
+{
+	xfree(topo_node_sw);
+	xfree(topo_node_sw_inx);
+	topo_node_cnt = 0;
+	topo_switch_cnt = 0;
+}
+
+/* Build the index of the switches containing each node, unless it is
+ * current. Switches of node i are topo_node_sw[topo_node_sw_inx[i]] through
+ * topo_node_sw[topo_node_sw_inx[i + 1] - 1] */
+static void _topo_cache_build(uint32_t cr_node_cnt)
+{
+	int i, j, first, last, sw_cnt = 0;
+	int *node_inx;
+
+	if (topo_node_sw_inx && (topo_node_cnt == cr_node_cnt) &&
+	    (topo_switch_cnt == switch_record_cnt))
+		return;
+
+	cr_fini_topo_cache();
+	topo_node_sw_inx = xmalloc(sizeof(int) * (cr_node_cnt + 1));
+	for (j = 0; j < switch_record_cnt; j++) {
+		first = bit_ffs(switch_record_table[j].node_bitmap);
+		if (first < 0)
+			continue;
+		last = bit_fls(switch_record_table[j].node_bitmap);
+		for (i = first; (i <= last) && (i < cr_node_cnt); i++) {
+			if (!bit_test(switch_record_table[j].node_bitmap, i))
+				continue;
+			topo_node_sw_inx[i + 1]++;
+			sw_cnt++;
+		}
+	}
+	for (i = 0; i < cr_node_cnt; i++)
+		topo_node_sw_inx[i + 1] += topo_node_sw_inx[i];
+
+	topo_node_sw = xmalloc(sizeof(int) * MAX(sw_cnt, 1));
+	node_inx = xmalloc(sizeof(int) * (cr_node_cnt + 1));
+	memcpy(node_inx, topo_node_sw_inx, sizeof(int) * (cr_node_cnt + 1));
+	for (j = 0; j < switch_record_cnt; j++) {
+		first = bit_ffs(switch_record_table[j].node_bitmap);
+		if (first < 0)
+			continue;
+		last = bit_fls(switch_record_table[j].node_bitmap);
+		for (i = first; (i <= last) && (i < cr_node_cnt); i++) {
+			if (bit_test(switch_record_table[j].node_bitmap, i))
+				topo_node_sw[node_inx[i]++] = j;
+		}
+	}
+	xfree(node_inx);
+
+	topo_node_cnt = cr_node_cnt;
+	topo_switch_cnt = switch_record_cnt;
+}
+
+/* Add the CPUs available on each node of avail_bitmap to the count of every
+ * switch containing that node. One pass over the nodes rather than one per
+ * switch. Every node in avail_bitmap must be set in switches_bitmap[] of the
+ * switches containing it. */
+static void _topo_sum_cpus(bitstr_t *avail_bitmap, uint16_t *cpu_cnt,
+			   int *switches_cpu_cnt)
+{
+	int i, k, first, last;
+
+	first = bit_ffs(avail_bitmap);
+	if (first < 0)
+		return;
+	last = bit_fls(avail_bitmap);
+	for (i = first; i <= last; i++) {
+		if (!bit_test(avail_bitmap, i))
+			continue;
+		for (k = topo_node_sw_inx[i]; k < topo_node_sw_inx[i + 1]; k++)
+			switches_cpu_cnt[topo_node_sw[k]] += cpu_cnt[i];
+	}
+}
+
 /*
  * A network topology aware version of _eval_nodes().
  * NOTE: The logic here is almost identical to that of _job_test_topo()
@@ -2021,7 +2139,7 @@ static int _eval_nodes_topo(struct job_record *job_ptr, bitstr_t *bitmap,
 	int min_rem_nodes;	/* remaining resources desired */
 	int avail_cpus;
 	int total_cpus = 0;	/* #CPUs allocated to job */
-	int i, j, rc = SLURM_SUCCESS;
+	int i, j, k, rc = SLURM_SUCCESS;
 	int best_fit_inx, first, last;
 	int best_fit_nodes, best_fit_cpus;
 	int best_fit_location = 0, best_fit_sufficient;
@@ -2054,6 +2172,7 @@ static int _eval_nodes_topo(struct job_record *job_ptr, bitstr_t *bitmap,
 
 	/* Construct a set of switch array entries,
 	 * use the same indexes as switch_record_table in slurmctld */
+	_topo_cache_build(cr_node_cnt);
 	switches_bitmap   = xmalloc(sizeof(bitstr_t *) * switch_record_cnt);
 	switches_cpu_cnt  = xmalloc(sizeof(int)        * switch_record_cnt);
 	switches_node_cnt = xmalloc(sizeof(int)        * switch_record_cnt);
@@ -2141,7 +2260,9 @@ static int _eval_nodes_topo(struct job_record *job_ptr, bitstr_t *bitmap,
 			max_nodes--;
 			total_cpus += avail_cpus;
 			rem_cpus   -= avail_cpus;
-			for (j=0; j<switch_record_cnt; j++) {
+			for (k = topo_node_sw_inx[i];
+			     k < topo_node_sw_inx[i + 1]; k++) {
+				j = topo_node_sw[k];
 				if (!bit_test(switches_bitmap[j], i))
 					continue;
 				bit_clear(switches_bitmap[j], i);
@@ -2165,36 +2286,14 @@ static int _eval_nodes_topo(struct job_record *job_ptr, bitstr_t *bitmap,
 		for (j=0; j<switch_record_cnt; j++) {
 			if (switches_node_cnt[j] == 0)
 				continue;
-			first = bit_ffs(switches_bitmap[j]);
-			if (first < 0)
-				continue;
-			last  = bit_fls(switches_bitmap[j]);
-			for (i=first; i<=last; i++) {
-				if (!bit_test(switches_bitmap[j], i))
-					continue;
-				if (!bit_test(avail_nodes_bitmap, i)) {
-					/* cleared from lower level */
-					bit_clear(switches_bitmap[j], i);
-					switches_node_cnt[j]--;
-				} else {
-					switches_cpu_cnt[j] += cpu_cnt[i];
-				}
-			}
-		}
-	} else {
-		/* No specific required nodes, calculate CPU counts */
-		for (j=0; j<switch_record_cnt; j++) {
-			first = bit_ffs(switches_bitmap[j]);
-			if (first < 0)
-				continue;
-			last  = bit_fls(switches_bitmap[j]);
-			for (i=first; i<=last; i++) {
-				if (!bit_test(switches_bitmap[j], i))
-					continue;
-				switches_cpu_cnt[j] += cpu_cnt[i];
-			}
+			/* clear nodes cleared from lower level */
+			bit_and(switches_bitmap[j], avail_nodes_bitmap);
+			switches_node_cnt[j] =
+				bit_set_count(switches_bitmap[j]);
 		}
 	}
+	/* Calculate CPU counts */
+	_topo_sum_cpus(avail_nodes_bitmap, cpu_cnt, switches_cpu_cnt);
 
 	/* Determine lowest level switch satisfying request with best fit
 	 * in respect of the specific required nodes if specified
@@ -2476,7 +2575,7 @@ static int _eval_nodes_dfly(struct job_record *job_ptr, bitstr_t *bitmap,
 	int min_rem_nodes;	/* remaining resources desired */
 	int avail_cpus;
 	int total_cpus = 0;	/* #CPUs allocated to job */
-	int i, j, rc = SLURM_SUCCESS;
+	int i, j, k, rc = SLURM_SUCCESS;
 	int best_fit_inx, first, last;
 	int best_fit_nodes, best_fit_cpus;
 	int best_fit_location = 0;
@@ -2516,6 +2615,7 @@ static int _eval_nodes_dfly(struct job_record *job_ptr, bitstr_t *bitmap,
 
 	/* Construct a set of switch array entries,
 	 * use the same indexes as switch_record_table in slurmctld */
+	_topo_cache_build(cr_node_cnt);
 	switches_bitmap   = xmalloc(sizeof(bitstr_t *) * switch_record_cnt);
 	switches_cpu_cnt  = xmalloc(sizeof(int)        * switch_record_cnt);
 	switches_node_cnt = xmalloc(sizeof(int)        * switch_record_cnt);
@@ -2597,7 +2697,9 @@ static int _eval_nodes_dfly(struct job_record *job_ptr, bitstr_t *bitmap,
 			max_nodes--;
 			total_cpus += avail_cpus;
 			rem_cpus   -= avail_cpus;
-			for (j = 0; j < switch_record_cnt; j++) {
+			for (k = topo_node_sw_inx[i];
+			     k < topo_node_sw_inx[i + 1]; k++) {
+				j = topo_node_sw[k];
 				if (!bit_test(switches_bitmap[j], i))
 					continue;
 				bit_clear(switches_bitmap[j], i);
@@ -2624,36 +2726,14 @@ static int _eval_nodes_dfly(struct job_record *job_ptr, bitstr_t *bitmap,
 		for (j = 0; j < switch_record_cnt; j++) {
 			if (switches_node_cnt[j] == 0)
 				continue;
-			first = bit_ffs(switches_bitmap[j]);
-			if (first < 0)
-				continue;
-			last  = bit_fls(switches_bitmap[j]);
-			for (i = first; i <= last; i++) {
-				if (!bit_test(switches_bitmap[j], i))
-					continue;
-				if (!bit_test(avail_nodes_bitmap, i)) {
-					/* cleared from lower level */
-					bit_clear(switches_bitmap[j], i);
-					switches_node_cnt[j]--;
-				} else {
-					switches_cpu_cnt[j] += cpu_cnt[i];
-				}
-			}
-		}
-	} else {
-		/* No specific required nodes, calculate CPU counts */
-		for (j = 0; j < switch_record_cnt; j++) {
-			first = bit_ffs(switches_bitmap[j]);
-			if (first < 0)
-				continue;
-			last  = bit_fls(switches_bitmap[j]);
-			for (i = first; i <= last; i++) {
-				if (!bit_test(switches_bitmap[j], i))
-					continue;
-				switches_cpu_cnt[j] += cpu_cnt[i];
-			}
+			/* clear nodes cleared from lower level */
+			bit_and(switches_bitmap[j], avail_nodes_bitmap);
+			switches_node_cnt[j] =
+				bit_set_count(switches_bitmap[j]);
 		}
 	}
+	/* Calculate CPU counts */
+	_topo_sum_cpus(avail_nodes_bitmap, cpu_cnt, switches_cpu_cnt);
 
 	/* Determine lowest level switch satisfying request with best fit 
 	 * in respect of the specific required nodes if specified
@@ -3321,6 +3401,23 @@ extern int cr_job_test(struct job_record *job_ptr, bitstr_t *node_bitmap,
 	if (job_ptr->details->whole_node == 1)
 		_block_whole_nodes(node_bitmap, avail_cores, free_cores);
 
+	/* Nodes with every core in some row have no idle resources, skip
+	 * them without evaluating their cores. Required nodes are left for
+	 * _select_nodes() to reject. */
+	first = bit_ffs(node_bitmap);
+	if (first != -1)
+		last = bit_fls(node_bitmap);
+	else
+		last = first - 1;
+	for (i = first; i <= last; i++) {
+		if (!bit_test(node_bitmap, i) || node_usage[i].idle_cores)
+			continue;
+		if (job_ptr->details->req_node_bitmap &&
+		    bit_test(job_ptr->details->req_node_bitmap, i))
+			continue;
+		bit_clear(node_bitmap, i);
+	}
+
 	cpu_count = _select_nodes(job_ptr, min_nodes, max_nodes, req_nodes,
 				  node_bitmap, cr_node_cnt, free_cores,
 				  node_usage, cr_type, test_only,
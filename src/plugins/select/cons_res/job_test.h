@@ -78,4 +78,8 @@ int cr_job_test(struct job_record *job_ptr, bitstr_t *node_bitmap,
  */
 extern bitstr_t *make_core_bitmap(bitstr_t *node_map, uint16_t core_spec);
 
+/* Free the node to switch index used by topology aware node selection,
+ * call when the node or switch tables may have changed */
+extern void cr_fini_topo_cache(void);
+
 #endif /* !_CR_JOB_TEST_H */
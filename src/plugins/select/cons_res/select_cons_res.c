@@ -190,6 +190,14 @@ bool     topo_optional        = false;
 struct part_res_record *select_part_record = NULL;
 struct node_res_record *select_node_record = NULL;
 struct node_use_record *select_node_usage  = NULL;
+
+/* Core of a job and whether it was idle, see _get_idle_cores() */
+typedef struct {
+	int node_inx;
+	uint32_t core;		/* index in the row bitmaps */
+	bool idle;		/* in no row of any partition */
+} idle_core_t;
+
 static bool select_state_initializing = true;
 static int select_node_cnt = 0;
 static int preempt_reorder_cnt = 1;
@@ -382,6 +390,7 @@ static struct node_use_record *_dup_node_usage(struct node_use_record *orig_ptr)
 	for (i = 0; i < select_node_cnt; i++) {
 		new_ptr[i].node_state   = orig_ptr[i].node_state;
 		new_ptr[i].alloc_memory = orig_ptr[i].alloc_memory;
+		new_ptr[i].idle_cores   = orig_ptr[i].idle_cores;
 		if (orig_ptr[i].gres_list)
 			gres_list = orig_ptr[i].gres_list;
 		else
@@ -805,6 +814,107 @@ static void _build_row_bitmaps(struct part_res_record *p_ptr,
 }
 
 
+/* Test if core "c" of the row bitmaps is in a row of any partition */
+static bool _core_in_row(struct part_res_record *part_record_ptr, uint32_t c)
+{
+	struct part_res_record *p_ptr;
+	int r;
+
+	for (p_ptr = part_record_ptr; p_ptr; p_ptr = p_ptr->next) {
+		if (!p_ptr->row)
+			continue;
+		for (r = 0; r < p_ptr->num_rows; r++) {
+			if (p_ptr->row[r].row_bitmap &&
+			    bit_test(p_ptr->row[r].row_bitmap, c))
+				return true;
+		}
+	}
+	return false;
+}
+
+/*
+ * _get_idle_cores - record which of a set of cores are now in no row of any
+ *	partition, call before the rows change and pass the result to
+ *	_set_idle_cores() after the change
+ * IN part_record_ptr - partitions with the row bitmaps to test
+ * IN job - the cores of this job on every node of it, or (if NULL) every
+ *	core of node node_inx
+ * IN node_inx - node index, used if job is NULL
+ * OUT core_cnt - count of records returned
+ * RET array of core records, xfree() it after _set_idle_cores()
+ */
+static idle_core_t *_get_idle_cores(struct part_res_record *part_record_ptr,
+				    struct job_resources *job, int node_inx,
+				    uint32_t *core_cnt)
+{
+	idle_core_t *cores;
+	int i, i_first, i_last;
+	uint32_t c, c_first, c_last, cnt = 0, job_bit_inx = 0;
+
+	if (job) {
+		i_first = bit_ffs(job->node_bitmap);
+		if (i_first == -1)
+			i_last = -2;
+		else
+			i_last = bit_fls(job->node_bitmap);
+	} else {
+		i_first = i_last = node_inx;
+	}
+	for (i = i_first; i <= i_last; i++) {
+		if (job && !bit_test(job->node_bitmap, i))
+			continue;
+		cnt += cr_get_coremap_offset(i + 1) - cr_get_coremap_offset(i);
+	}
+	cores = xmalloc(sizeof(idle_core_t) * MAX(cnt, 1));
+	cnt = 0;
+
+	/* Map job cores to row bitmap cores as add_job_to_cores() does */
+	for (i = i_first; i <= i_last; i++) {
+		if (job && !bit_test(job->node_bitmap, i))
+			continue;
+		c_first = cr_get_coremap_offset(i);
+		c_last  = cr_get_coremap_offset(i + 1);
+		for (c = c_first; c < c_last; c++) {
+			if (job && (job->whole_node != 1) &&
+			    !bit_test(job->core_bitmap,
+				      job_bit_inx + (c - c_first)))
+				continue;
+			cores[cnt].node_inx = i;
+			cores[cnt].core = c;
+			cores[cnt].idle = !_core_in_row(part_record_ptr, c);
+			cnt++;
+		}
+		job_bit_inx += c_last - c_first;
+	}
+
+	*core_cnt = cnt;
+	return cores;
+}
+
+/*
+ * _set_idle_cores - update node_usage[].idle_cores for the cores recorded by
+ *	_get_idle_cores() which became idle or busy since. Call after the rows
+ *	of any partition change, cr_job_test() skips nodes with no idle cores
+ *	when seeking idle resources.
+ */
+static void _set_idle_cores(struct part_res_record *part_record_ptr,
+			    struct node_use_record *node_usage,
+			    idle_core_t *cores, uint32_t core_cnt)
+{
+	uint32_t i;
+	bool idle;
+
+	for (i = 0; i < core_cnt; i++) {
+		idle = !_core_in_row(part_record_ptr, cores[i].core);
+		if (idle == cores[i].idle)
+			continue;
+		if (idle)
+			node_usage[cores[i].node_inx].idle_cores++;
+		else if (node_usage[cores[i].node_inx].idle_cores)
+			node_usage[cores[i].node_inx].idle_cores--;
+	}
+}
+
 /* allocate resources to the given job
  * - add 'struct job_resources' resources to 'struct part_res_record'
  * - add job's memory requirements to 'struct node_res_record'
@@ -821,6 +931,8 @@ static int _add_job_to_res(struct job_record *job_ptr, int action)
 	List gres_list;
 	int i, i_first, i_last, n;
 	bitstr_t *core_bitmap;
+	idle_core_t *idle_cores;
+	uint32_t idle_core_cnt;
 
 	if (!job || !job->core_bitmap) {
 		error("%s: job %u has no job_resrcs info",
@@ -904,6 +1016,9 @@ static int _add_job_to_res(struct job_record *job_ptr, int action)
 					     sizeof(struct part_row_data));
 		}
 
+		idle_cores = _get_idle_cores(select_part_record, job, 0,
+					     &idle_core_cnt);
+
 		/* find a row to add this job */
 		for (i = 0; i < p_ptr->num_rows; i++) {
 			if (!_can_job_fit_in_row(job, &(p_ptr->row[i])))
@@ -932,6 +1047,9 @@ static int _add_job_to_res(struct job_record *job_ptr, int action)
 					job->node_req;
 			}
 		}
+		_set_idle_cores(select_part_record, select_node_usage,
+				idle_cores, idle_core_cnt);
+		xfree(idle_cores);
 		if (select_debug_flags & DEBUG_FLAG_SELECT_TYPE) {
 			info("DEBUG: _add_job_to_res (after):");
 			_dump_part(p_ptr);
@@ -1290,8 +1408,16 @@ static int _rm_job_from_res(struct part_res_record *part_record_ptr,
 			}
 		}
 		if (n) {
+			idle_core_t *idle_cores;
+			uint32_t idle_core_cnt;
+
 			/* job was found and removed, so refresh the bitmaps */
+			idle_cores = _get_idle_cores(part_record_ptr, job, 0,
+						     &idle_core_cnt);
 			_build_row_bitmaps(p_ptr, job_ptr);
+			_set_idle_cores(part_record_ptr, node_usage,
+					idle_cores, idle_core_cnt);
+			xfree(idle_cores);
 			/* Adjust the node_state of all nodes affected by
 			 * the removal of this job. If all cores are now
 			 * available, set node_state = NODE_CR_AVAILABLE
@@ -1334,6 +1460,8 @@ static int _rm_job_from_one_node(struct job_record *job_ptr,
 	int first_bit, last_bit;
 	int i, node_inx, n;
 	List gres_list;
+	idle_core_t *idle_cores;
+	uint32_t idle_core_cnt;
 
 	if (!job || !job->core_bitmap) {
 		error("%s: select/cons_res: job %u has no job_resrcs info",
@@ -1431,8 +1559,13 @@ static int _rm_job_from_one_node(struct job_record *job_ptr,
 	}
 
 
-	/* some node of job removed from core-bitmap, so refresh CR bitmaps */
+	/* some node of job removed from core-bitmap, so refresh CR bitmaps.
+	 * The job's cores on node_inx are no longer in its core_bitmap. */
+	idle_cores = _get_idle_cores(part_record_ptr, NULL, node_inx,
+				     &idle_core_cnt);
 	_build_row_bitmaps(p_ptr, NULL);
+	_set_idle_cores(part_record_ptr, node_usage, idle_cores, idle_core_cnt);
+	xfree(idle_cores);
 
 	/* Adjust the node_state of the node removed from this job.
 	 * If all cores are now available, set node_state = NODE_CR_AVAILABLE */
@@ -2050,6 +2183,7 @@ extern int fini(void)
 	_destroy_part_data(select_part_record);
 	select_part_record = NULL;
 	cr_fini_global_core_data();
+	cr_fini_topo_cache();
 
 	if (cr_type)
 		verbose("%s shutting down ...", plugin_name);
@@ -2179,6 +2313,7 @@ extern int select_p_node_init(struct node_record *node_ptr, int node_cnt)
 	select_state_initializing = true;
 	select_fast_schedule = slurm_get_fast_schedule();
 	cr_init_global_core_data(node_ptr, node_cnt, select_fast_schedule);
+	cr_fini_topo_cache();	/* switch_record_table may have changed */
 
 	_destroy_node_data(select_node_usage, select_node_record);
 	select_node_cnt  = node_cnt;
@@ -2218,6 +2353,8 @@ extern int select_p_node_init(struct node_record *node_ptr, int node_cnt)
 		if (tot_core >= select_node_record[i].cpus)
 			select_node_record[i].vpus = 1;
 		select_node_usage[i].node_state = NODE_CR_AVAILABLE;
+		select_node_usage[i].idle_cores = cr_get_coremap_offset(i + 1) -
+						  cr_get_coremap_offset(i);
 		gres_plugin_node_state_dealloc_all(select_node_record[i].
 						   node_ptr->gres_list);
 	}
@@ -101,6 +101,8 @@ struct node_use_record {
 					 * scheduled jobs */
 	List gres_list;			/* list of gres state info managed by 
 					 * plugins */
+	uint16_t idle_cores;		/* count of cores in no row of any
+					 * partition, see _set_idle_cores() */
 	uint16_t node_state;		/* see node_cr_state comments */
 };
 
@@ -170,6 +170,17 @@ static int _print_stats(void)
 		       buf->bf_queue_len_sum / buf->bf_cycle_counter);
 	}
 
+	if (buf->aggr_comp_cnt > 0) {
+		printf("\nMessage aggregation stats (microseconds)\n");
+		printf("\tComposite messages: %u\n", buf->aggr_comp_cnt);
+		printf("\tAggregated messages: %u\n", buf->aggr_msg_cnt);
+		printf("\tMessages per composite mean: %.2f\n",
+		       (double) buf->aggr_msg_cnt / buf->aggr_comp_cnt);
+		printf("\tWindow time mean: %"PRIu64"\n",
+		       buf->aggr_window_sum / buf->aggr_comp_cnt);
+		printf("\tWindow time max:  %u\n", buf->aggr_window_max);
+	}
+
 	printf("\nRemote Procedure Call statistics by message type\n");
 	for (i = 0; i < buf->rpc_type_size; i++) {
 		printf("\t%-40s(%5u) count:%-6u "
@@ -40,6 +40,7 @@
 
 #include "src/common/assoc_mgr.h"
 #include "src/common/slurm_accounting_storage.h"
+#include "src/common/xhash.h"
 
 #include "src/slurmctld/slurmctld.h"
 #include "src/slurmctld/acct_policy.h"
@@ -356,90 +357,201 @@ static void _set_qos_order(struct job_record *job_ptr,
 	return;
 }
 
-static int _find_used_limits_for_acct(void *x, void *key)
+/*
+ * Entry of the per QOS indexes of acct_limit_list and user_limit_list. The
+ * used limits records are owned by the lists, the index only points to them.
+ */
+typedef struct {
+	char *key;	/* account name or uid */
+	slurmdb_used_limits_t *used_limits;
+} used_limits_idx_t;
+
+static const char *_used_limits_idx_id(void *item)
 {
-	slurmdb_used_limits_t *used_limits = (slurmdb_used_limits_t *)x;
-	char *account = (char *)key;
+	used_limits_idx_t *idx = (used_limits_idx_t *)item;
+
+	return idx->key;
+}
 
-	if (!xstrcmp(account, used_limits->acct))
-		return 1;
+static void _used_limits_idx_free(void *item)
+{
+	used_limits_idx_t *idx = (used_limits_idx_t *)item;
 
-	return 0;
+	xfree(idx->key);
+	xfree(idx);
 }
 
-/* Checks for record in *user_limit_list of user_id if
- * *user_limit_list doesn't exist it will create it, if the user_id
- * record doesn't exist it will add it to the list.
- * In all cases the user record is returned.
- */
-static slurmdb_used_limits_t *_get_acct_used_limits(
-	List *acct_limit_list, char *acct)
+/* Create a used limits record and add it to list and index under key */
+static slurmdb_used_limits_t *_add_used_limits(
+	List *limit_list, void **limit_hash, char *key)
 {
 	slurmdb_used_limits_t *used_limits;
+	used_limits_idx_t *idx;
+	int i = sizeof(uint64_t) * slurmctld_tres_cnt;
 
-	xassert(acct_limit_list);
+	if (!*limit_list)
+		*limit_list = list_create(slurmdb_destroy_used_limits);
+	if (!*limit_hash)
+		*limit_hash = xhash_init(_used_limits_idx_id,
+					 _used_limits_idx_free, NULL, 0);
 
-	if (!*acct_limit_list)
-		*acct_limit_list = list_create(slurmdb_destroy_used_limits);
+	used_limits = xmalloc(sizeof(slurmdb_used_limits_t));
+	used_limits->tres = xmalloc(i);
+	used_limits->tres_run_mins = xmalloc(i);
+	list_append(*limit_list, used_limits);
 
-	if (!(used_limits = list_find_first(*acct_limit_list,
-					    _find_used_limits_for_acct,
-					    acct))) {
-		int i = sizeof(uint64_t) * slurmctld_tres_cnt;
+	idx = xmalloc(sizeof(used_limits_idx_t));
+	idx->key = xstrdup(key);
+	idx->used_limits = used_limits;
+	xhash_add(*limit_hash, idx);
 
-		used_limits = xmalloc(sizeof(slurmdb_used_limits_t));
-		used_limits->acct = xstrdup(acct);
+	return used_limits;
+}
 
-		used_limits->tres = xmalloc(i);
-		used_limits->tres_run_mins = xmalloc(i);
+/* Look up a used limits record by key in the index of its list */
+static slurmdb_used_limits_t *_find_used_limits(void *limit_hash, char *key)
+{
+	used_limits_idx_t *idx;
 
-		list_append(*acct_limit_list, used_limits);
-	}
+	if (!limit_hash || !(idx = xhash_get(limit_hash, key)))
+		return NULL;
 
-	return used_limits;
+	return idx->used_limits;
 }
 
-static int _find_used_limits_for_user(void *x, void *key)
+/* Checks for record in acct_limit_list of the QOS for acct, if the list
+ * doesn't exist it will create it, if the acct record doesn't exist it
+ * will add it to the list.
+ * In all cases the acct record is returned.
+ */
+static slurmdb_used_limits_t *_get_acct_used_limits(
+	slurmdb_qos_usage_t *usage, char *acct)
 {
-	slurmdb_used_limits_t *used_limits = (slurmdb_used_limits_t *)x;
-	uint32_t user_id = *(uint32_t *)key;
+	slurmdb_used_limits_t *used_limits;
+	char *key = acct ? acct : "";
 
-	if (used_limits->uid == user_id)
-		return 1;
+	xassert(usage);
 
-	return 0;
+	if (!(used_limits = _find_used_limits(usage->acct_limit_hash, key))) {
+		used_limits = _add_used_limits(&usage->acct_limit_list,
+					       &usage->acct_limit_hash, key);
+		used_limits->acct = xstrdup(acct);
+	}
+
+	return used_limits;
 }
 
-/* Checks for record in *user_limit_list of user_id if
- * *user_limit_list doesn't exist it will create it, if the user_id
- * record doesn't exist it will add it to the list.
+/* Checks for record in user_limit_list of the QOS for user_id, if the
+ * list doesn't exist it will create it, if the user_id record doesn't
+ * exist it will add it to the list.
  * In all cases the user record is returned.
  */
 static slurmdb_used_limits_t *_get_user_used_limits(
-	List *user_limit_list, uint32_t user_id)
+	slurmdb_qos_usage_t *usage, uint32_t user_id)
 {
 	slurmdb_used_limits_t *used_limits;
+	char key[16];
 
-	xassert(user_limit_list);
+	xassert(usage);
 
-	if (!*user_limit_list)
-		*user_limit_list = list_create(slurmdb_destroy_used_limits);
+	snprintf(key, sizeof(key), "%u", user_id);
+	if (!(used_limits = _find_used_limits(usage->user_limit_hash, key))) {
+		used_limits = _add_used_limits(&usage->user_limit_list,
+					       &usage->user_limit_hash, key);
+		used_limits->uid = user_id;
+	}
 
-	if (!(used_limits = list_find_first(*user_limit_list,
-					    _find_used_limits_for_user,
-					    &user_id))) {
-		int i = sizeof(uint64_t) * slurmctld_tres_cnt;
+	return used_limits;
+}
 
-		used_limits = xmalloc(sizeof(slurmdb_used_limits_t));
-		used_limits->uid = user_id;
+/*
+ * Cache of job count limits found exhausted during a scheduling cycle,
+ * keyed by association and QOS pair. Only reasons that do not depend on
+ * the job itself are recorded, so every other pending job of the same
+ * association and QOS can be held without walking the limits again.
+ * Jobs starting only add usage, jobs ending clear the cache.
+ */
+typedef struct {
+	char key[40];		/* "assoc_id,qos_id_1,qos_id_2" */
+	uint32_t state_reason;
+} limit_cache_ent_t;
 
-		used_limits->tres = xmalloc(i);
-		used_limits->tres_run_mins = xmalloc(i);
+static pthread_mutex_t limit_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static xhash_t *limit_cache = NULL;
+static int limit_cache_users = 0;
+
+static const char *_limit_cache_id(void *item)
+{
+	limit_cache_ent_t *ent = (limit_cache_ent_t *)item;
 
-		list_append(*user_limit_list, used_limits);
+	return ent->key;
+}
+
+static void _limit_cache_free(void *item)
+{
+	xfree(item);
+}
+
+static void _limit_cache_key(char *key, int size,
+			     slurmdb_assoc_rec_t *assoc_ptr,
+			     slurmdb_qos_rec_t *qos_ptr_1,
+			     slurmdb_qos_rec_t *qos_ptr_2)
+{
+	snprintf(key, size, "%u,%u,%u",
+		 assoc_ptr ? assoc_ptr->id : 0,
+		 qos_ptr_1 ? qos_ptr_1->id : 0,
+		 qos_ptr_2 ? qos_ptr_2->id : 0);
+}
+
+/* Return true if state_reason is a job count limit of the association or
+ * QOS which is the same for every job sharing them */
+static bool _limit_cache_reason(uint32_t state_reason)
+{
+	switch (state_reason) {
+	case WAIT_QOS_GRP_JOB:
+	case WAIT_QOS_MAX_JOB_PER_ACCT:
+	case WAIT_QOS_MAX_JOB_PER_USER:
+	case WAIT_ASSOC_GRP_JOB:
+	case WAIT_ASSOC_MAX_JOBS:
+		return true;
+	default:
+		return false;
 	}
+}
 
-	return used_limits;
+static uint32_t _limit_cache_get(char *key)
+{
+	limit_cache_ent_t *ent;
+	uint32_t state_reason = WAIT_NO_REASON;
+
+	slurm_mutex_lock(&limit_cache_mutex);
+	if (limit_cache && (ent = xhash_get(limit_cache, key)))
+		state_reason = ent->state_reason;
+	slurm_mutex_unlock(&limit_cache_mutex);
+
+	return state_reason;
+}
+
+static void _limit_cache_add(char *key, uint32_t state_reason)
+{
+	limit_cache_ent_t *ent;
+
+	slurm_mutex_lock(&limit_cache_mutex);
+	if (limit_cache && !xhash_get(limit_cache, key)) {
+		ent = xmalloc(sizeof(limit_cache_ent_t));
+		strlcpy(ent->key, key, sizeof(ent->key));
+		ent->state_reason = state_reason;
+		xhash_add(limit_cache, ent);
+	}
+	slurm_mutex_unlock(&limit_cache_mutex);
+}
+
+static void _limit_cache_clear(void)
+{
+	slurm_mutex_lock(&limit_cache_mutex);
+	if (limit_cache)
+		xhash_clear(limit_cache);
+	slurm_mutex_unlock(&limit_cache_mutex);
 }
 
 static bool _valid_job_assoc(struct job_record *job_ptr)
@@ -481,10 +593,10 @@ static void _qos_adjust_limit_usage(int type, struct job_record *job_ptr,
 	if (!qos_ptr || !job_ptr->assoc_ptr)
 		return;
 
-	used_limits_a =	_get_acct_used_limits(&qos_ptr->usage->acct_limit_list,
+	used_limits_a =	_get_acct_used_limits(qos_ptr->usage,
 					      job_ptr->assoc_ptr->acct);
 
-	used_limits = _get_user_used_limits(&qos_ptr->usage->user_limit_list,
+	used_limits = _get_user_used_limits(qos_ptr->usage,
 					    job_ptr->user_id);
 
 	switch(type) {
@@ -1632,9 +1744,7 @@ static int _qos_policy_validate(job_desc_msg_t *job_desc,
 	if ((qos_out_ptr->max_submit_jobs_pa == INFINITE) &&
 	    (qos_ptr->max_submit_jobs_pa != INFINITE)) {
 		slurmdb_used_limits_t *used_limits =
-			_get_acct_used_limits(
-				&qos_ptr->usage->acct_limit_list,
-				assoc_ptr->acct);
+			_get_acct_used_limits(qos_ptr->usage, assoc_ptr->acct);
 
 		qos_out_ptr->max_submit_jobs_pa = qos_ptr->max_submit_jobs_pa;
 
@@ -1654,9 +1764,8 @@ static int _qos_policy_validate(job_desc_msg_t *job_desc,
 	if ((qos_out_ptr->max_submit_jobs_pu == INFINITE) &&
 	    (qos_ptr->max_submit_jobs_pu != INFINITE)) {
 		slurmdb_used_limits_t *used_limits =
-			_get_user_used_limits(
-				&qos_ptr->usage->user_limit_list,
-				job_desc->user_id);
+			_get_user_used_limits(qos_ptr->usage,
+					      job_desc->user_id);
 
 		qos_out_ptr->max_submit_jobs_pu = qos_ptr->max_submit_jobs_pu;
 
@@ -1725,10 +1834,10 @@ static int _qos_job_runnable_pre_select(struct job_record *job_ptr,
 
 	wall_mins = qos_ptr->usage->grp_used_wall / 60;
 
-	used_limits_a =	_get_acct_used_limits(&qos_ptr->usage->acct_limit_list,
+	used_limits_a =	_get_acct_used_limits(qos_ptr->usage,
 					      assoc_ptr->acct);
 
-	used_limits = _get_user_used_limits(&qos_ptr->usage->user_limit_list,
+	used_limits = _get_user_used_limits(qos_ptr->usage,
 					    job_ptr->user_id);
 
 
@@ -1931,10 +2040,10 @@ static int _qos_job_runnable_post_select(struct job_record *job_ptr,
 			(uint64_t)(qos_ptr->usage->usage_tres_raw[i] / 60.0);
 	}
 
-	used_limits_a =	_get_acct_used_limits(&qos_ptr->usage->acct_limit_list,
+	used_limits_a =	_get_acct_used_limits(qos_ptr->usage,
 					      assoc_ptr->acct);
 
-	used_limits = _get_user_used_limits(&qos_ptr->usage->user_limit_list,
+	used_limits = _get_user_used_limits(qos_ptr->usage,
 					    job_ptr->user_id);
 
 	tres_usage = _validate_tres_usage_limits_for_qos(
@@ -2481,13 +2590,40 @@ extern void acct_policy_job_begin(struct job_record *job_ptr)
 extern void acct_policy_job_fini(struct job_record *job_ptr)
 {
 	/* if end_time_exp == NO_VAL this has already happened */
-	if (job_ptr->end_time_exp != (time_t)NO_VAL)
+	if (job_ptr->end_time_exp != (time_t)NO_VAL) {
 		_adjust_limit_usage(ACCT_POLICY_JOB_FINI, job_ptr);
-	else
+		/* Freed usage may let held jobs run */
+		_limit_cache_clear();
+	} else
 		debug2("We have already ran the job_fini for job %u",
 		       job_ptr->job_id);
 }
 
+/*
+ * acct_policy_cycle_begin - Start remembering job count limits found
+ *	exhausted until the matching acct_policy_cycle_end().
+ */
+extern void acct_policy_cycle_begin(void)
+{
+	slurm_mutex_lock(&limit_cache_mutex);
+	if (limit_cache_users++ == 0)
+		limit_cache = xhash_init(_limit_cache_id, _limit_cache_free,
+					 NULL, 0);
+	slurm_mutex_unlock(&limit_cache_mutex);
+}
+
+/*
+ * acct_policy_cycle_end - Forget the limits remembered since
+ *	acct_policy_cycle_begin() once no scheduler is using them.
+ */
+extern void acct_policy_cycle_end(void)
+{
+	slurm_mutex_lock(&limit_cache_mutex);
+	if (limit_cache_users && (--limit_cache_users == 0))
+		xhash_free(limit_cache);
+	slurm_mutex_unlock(&limit_cache_mutex);
+}
+
 extern void acct_policy_alter_job(struct job_record *job_ptr,
 				  uint32_t new_time_limit)
 {
@@ -3087,6 +3223,8 @@ extern bool acct_policy_job_runnable_pre_select(struct job_record *job_ptr)
 	int parent = 0; /* flag to tell us if we are looking at the
 			 * parent or not
 			 */
+	char cache_key[40];
+	uint32_t cache_reason;
 	assoc_mgr_lock_t locks = { READ_LOCK, NO_LOCK, READ_LOCK, NO_LOCK,
 				   READ_LOCK, NO_LOCK, NO_LOCK };
 
@@ -3118,6 +3256,18 @@ extern bool acct_policy_job_runnable_pre_select(struct job_record *job_ptr)
 
 	_set_qos_order(job_ptr, &qos_ptr_1, &qos_ptr_2);
 
+	_limit_cache_key(cache_key, sizeof(cache_key), job_ptr->assoc_ptr,
+			 qos_ptr_1, qos_ptr_2);
+	if ((cache_reason = _limit_cache_get(cache_key)) != WAIT_NO_REASON) {
+		xfree(job_ptr->state_desc);
+		job_ptr->state_reason = cache_reason;
+		debug3("job %u being held, %s limit reached earlier this "
+		       "scheduling cycle", job_ptr->job_id,
+		       job_reason_string(cache_reason));
+		rc = false;
+		goto end_it;
+	}
+
 	/* check the first QOS setting it's values in the qos_rec */
 	if (qos_ptr_1 &&
 	    !(rc = _qos_job_runnable_pre_select(job_ptr, qos_ptr_1, &qos_rec)))
@@ -3280,6 +3430,8 @@ extern bool acct_policy_job_runnable_pre_select(struct job_record *job_ptr)
 		parent = 1;
 	}
 end_it:
+	if (!rc && _limit_cache_reason(job_ptr->state_reason))
+		_limit_cache_add(cache_key, job_ptr->state_reason);
 	assoc_mgr_unlock(&locks);
 	slurmdb_free_qos_rec_members(&qos_rec);
 
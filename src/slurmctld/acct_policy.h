@@ -66,6 +66,20 @@ extern void acct_policy_job_begin(struct job_record *job_ptr);
  */
 extern void acct_policy_job_fini(struct job_record *job_ptr);
 
+/*
+ * acct_policy_cycle_begin - Start remembering association and QOS job
+ *	count limits found exhausted by acct_policy_job_runnable_pre_select()
+ *	so other jobs sharing them are held without re-evaluation. Call at
+ *	the start of a scheduling cycle with the job write lock held.
+ */
+extern void acct_policy_cycle_begin(void);
+
+/*
+ * acct_policy_cycle_end - End of a scheduling cycle started with
+ *	acct_policy_cycle_begin().
+ */
+extern void acct_policy_cycle_end(void);
+
 /*
  * acct_policy_alter_job - if resources change on a job this needs to
  * be called after they have been validated, but before they actually
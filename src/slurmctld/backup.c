@@ -68,11 +68,43 @@
 
 #define SHUTDOWN_WAIT     2	/* Time to wait for primary server shutdown */
 
+#define REPLICA_IDLE_TIME 60	/* Stop refreshing a replica unused this long */
+#define REPLICA_MAX_AGE   10	/* Never serve a replica older than this */
+#define REPLICA_REFRESH   2	/* Seconds between replica refreshes */
+#define REPLICA_THREADS   8	/* Most info requests served at once */
+#define REPLICA_TIMEOUT   2000	/* Msec to wait for a replica refresh */
+
+/* Record types replicated from the primary controller */
+enum {
+	REPLICA_JOBS,
+	REPLICA_NODES,
+	REPLICA_PARTS,
+	REPLICA_TYPE_CNT
+};
+
+/*
+ * Body of the primary controller's last response to an info request, sent
+ * unchanged to clients which set SHOW_REPLICA while we are in standby mode.
+ */
+typedef struct {
+	char *data;		/* packed records, as sent by the primary */
+	uint32_t data_size;	/* size of data in bytes */
+	time_t fetch_time;	/* when the primary last confirmed data */
+	time_t last_request;	/* when a client last asked for the records */
+	time_t last_update;	/* time packed into data by the primary */
+} replica_t;
+
 static int          _background_process_msg(slurm_msg_t * msg);
 static void *       _background_rpc_mgr(void *no_data);
 static void *       _background_signal_hand(void *no_data);
 static void         _backup_reconfig(void);
 static int          _ping_controller(void);
+static void *       _replica_agent(void *no_data);
+static void         _replica_fetch(int type, int detail);
+static void         _replica_fini(void);
+static int          _replica_send(slurm_msg_t *msg);
+static void         _replica_serve(slurm_msg_t *msg);
+static void *       _replica_serve_thread(void *arg);
 static int          _shutdown_primary_controller(int wait_time);
 static void	     _trigger_slurmctld_event(uint32_t trig_type);
 inline static void  _update_cred_key(void);
@@ -82,6 +114,13 @@ static bool          dump_core = false;
 static volatile bool takeover = false;
 static time_t last_controller_response;
 
+static pthread_mutex_t replica_mutex = PTHREAD_MUTEX_INITIALIZER;
+static replica_t replica[REPLICA_TYPE_CNT][2];	/* by SHOW_DETAIL */
+static pthread_cond_t replica_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t replica_thread = 0;
+static int replica_thread_cnt = 0;	/* _replica_serve_thread() count */
+static volatile bool replica_stop = false;
+
 /*
  * Static list of signals to block in this process
  * *Must be zero-terminated*
@@ -124,6 +163,12 @@ void run_backup(slurm_trigger_callbacks_t *callbacks)
 	 */
 	slurm_thread_create(&slurmctld_config.thread_id_sig,
 			    _background_signal_hand, NULL);
+
+	/*
+	 * create attached thread to refresh replicas of primary's state
+	 */
+	replica_stop = false;
+	slurm_thread_create(&replica_thread, _replica_agent, NULL);
 	trigger_type = TRIGGER_TYPE_BU_CTLD_RES_OP;
 	_trigger_slurmctld_event(trigger_type);
 
@@ -171,6 +216,9 @@ void run_backup(slurm_trigger_callbacks_t *callbacks)
 		}
 	}
 
+	/* Stop fetching the primary's records before anything else */
+	replica_stop = true;
+
 	if (slurmctld_config.shutdown_time != 0) {
 		/* Since pidfile is created as user root (its owner is
 		 *   changed to SlurmUser) SlurmUser may not be able to
@@ -203,6 +251,7 @@ void run_backup(slurm_trigger_callbacks_t *callbacks)
 	pthread_kill(slurmctld_config.thread_id_sig, SIGTERM);
 	pthread_join(slurmctld_config.thread_id_sig, NULL);
 	pthread_join(slurmctld_config.thread_id_rpc, NULL);
+	_replica_fini();
 
 	/* The job list needs to be freed before we run
 	 * ctld_assoc_mgr_init, it should be empty here in the first place.
@@ -359,6 +408,14 @@ static void *_background_rpc_mgr(void *no_data)
 		if (slurm_receive_msg(newsockfd, &msg, 0) != 0)
 			error("slurm_receive_msg: %m");
 
+		if ((msg.msg_type == REQUEST_JOB_INFO)  ||
+		    (msg.msg_type == REQUEST_NODE_INFO) ||
+		    (msg.msg_type == REQUEST_PARTITION_INFO)) {
+			/* Takes the message and closes newsockfd */
+			_replica_serve(&msg);
+			continue;
+		}
+
 		error_code = _background_process_msg(&msg);
 		if ((error_code == SLURM_SUCCESS)			&&
 		    (msg.msg_type == REQUEST_SHUTDOWN_IMMEDIATE)	&&
@@ -454,6 +511,347 @@ static int _ping_controller(void)
 	return SLURM_PROTOCOL_SUCCESS;
 }
 
+/*
+ * _replica_agent - Keep replicas of the primary controller's job, node and
+ *	partition records current while clients are reading them
+ */
+static void *_replica_agent(void *no_data)
+{
+	int detail, type;
+	bool refresh;
+	replica_t *rec;
+	time_t now;
+
+	while (!replica_stop && (slurmctld_config.shutdown_time == 0)) {
+		sleep(1);
+		now = time(NULL);
+		for (type = 0; type < REPLICA_TYPE_CNT; type++) {
+			for (detail = 0; detail < 2; detail++) {
+				rec = &replica[type][detail];
+				slurm_mutex_lock(&replica_mutex);
+				refresh = false;
+				if (difftime(now, rec->last_request) >=
+				    REPLICA_IDLE_TIME) {
+					xfree(rec->data);
+					rec->data_size = 0;
+					rec->last_update = 0;
+				} else if (difftime(now, rec->fetch_time) >=
+					   REPLICA_REFRESH) {
+					refresh = true;
+				}
+				slurm_mutex_unlock(&replica_mutex);
+				/* Don't delay a takeover or shutdown */
+				if (replica_stop ||
+				    slurmctld_config.shutdown_time)
+					return NULL;
+				if (refresh)
+					_replica_fetch(type, detail);
+			}
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * _replica_fetch - Request records from the primary controller, keeping the
+ *	body of its response for _replica_send()
+ * IN type - REPLICA_JOBS, REPLICA_NODES or REPLICA_PARTS
+ * IN detail - set to replicate records packed with SHOW_DETAIL
+ */
+static void _replica_fetch(int type, int detail)
+{
+	slurm_msg_t req_msg, resp_msg;
+	job_info_request_msg_t job_req;
+	node_info_request_msg_t node_req;
+	part_info_request_msg_t part_req;
+	uint16_t resp_type = 0, show_flags = SHOW_ALL;
+	replica_t *rec = &replica[type][detail];
+	time_t last_update = 0;
+	int fd, rc;
+	/* Locks: Read configuration */
+	slurmctld_lock_t config_read_lock = {
+		READ_LOCK, NO_LOCK, NO_LOCK, NO_LOCK, NO_LOCK };
+
+	if (detail)
+		show_flags |= SHOW_DETAIL;
+
+	slurm_msg_t_init(&req_msg);
+	lock_slurmctld(config_read_lock);
+	slurm_set_addr(&req_msg.address, slurmctld_conf.slurmctld_port,
+		       slurmctld_conf.control_addr);
+	unlock_slurmctld(config_read_lock);
+
+	/* Only this thread changes the replica, so no lock to read it */
+	if (type == REPLICA_JOBS) {
+		memset(&job_req, 0, sizeof(job_info_request_msg_t));
+		job_req.last_update = rec->last_update;
+		job_req.show_flags = show_flags;
+		req_msg.msg_type = REQUEST_JOB_INFO;
+		req_msg.data = &job_req;
+		resp_type = RESPONSE_JOB_INFO;
+	} else if (type == REPLICA_NODES) {
+		memset(&node_req, 0, sizeof(node_info_request_msg_t));
+		node_req.last_update = rec->last_update;
+		node_req.show_flags = show_flags;
+		req_msg.msg_type = REQUEST_NODE_INFO;
+		req_msg.data = &node_req;
+		resp_type = RESPONSE_NODE_INFO;
+	} else {
+		memset(&part_req, 0, sizeof(part_info_request_msg_t));
+		part_req.last_update = rec->last_update;
+		part_req.show_flags = show_flags;
+		req_msg.msg_type = REQUEST_PARTITION_INFO;
+		req_msg.data = &part_req;
+		resp_type = RESPONSE_PARTITION_INFO;
+	}
+
+	if ((fd = slurm_open_msg_conn(&req_msg.address)) < 0) {
+		debug("%s: unable to contact primary controller: %m",
+		      __func__);
+		return;
+	}
+	if (slurm_send_node_msg(fd, &req_msg) < 0) {
+		debug("%s: %s send error: %m", __func__,
+		      rpc_num2string(req_msg.msg_type));
+		close(fd);
+		return;
+	}
+
+	/* Keep the buffer so the body can be replayed to clients as is */
+	slurm_msg_t_init(&resp_msg);
+	resp_msg.flags |= SLURM_MSG_KEEP_BUFFER;
+	rc = slurm_receive_msg(fd, &resp_msg, REPLICA_TIMEOUT);
+	close(fd);
+	if (rc != SLURM_SUCCESS) {
+		debug("%s: %s receive error: %m", __func__,
+		      rpc_num2string(req_msg.msg_type));
+		goto fini;
+	}
+
+	if (resp_msg.msg_type == RESPONSE_SLURM_RC) {
+		rc = ((return_code_msg_t *) resp_msg.data)->return_code;
+		slurm_free_return_code_msg(resp_msg.data);
+		if (rc == SLURM_NO_CHANGE_IN_DATA) {
+			slurm_mutex_lock(&replica_mutex);
+			rec->fetch_time = time(NULL);
+			slurm_mutex_unlock(&replica_mutex);
+		} else {
+			debug("%s: %s error: %s", __func__,
+			      rpc_num2string(req_msg.msg_type),
+			      slurm_strerror(rc));
+		}
+		goto fini;
+	} else if (resp_msg.msg_type != resp_type) {
+		error("%s: unexpected response %s to %s", __func__,
+		      rpc_num2string(resp_msg.msg_type),
+		      rpc_num2string(req_msg.msg_type));
+		slurm_free_msg_data(resp_msg.msg_type, resp_msg.data);
+		goto fini;
+	}
+
+	if (type == REPLICA_JOBS) {
+		last_update = ((job_info_msg_t *) resp_msg.data)->last_update;
+		slurm_free_job_info_msg(resp_msg.data);
+	} else if (type == REPLICA_NODES) {
+		last_update = ((node_info_msg_t *) resp_msg.data)->last_update;
+		slurm_free_node_info_msg(resp_msg.data);
+	} else {
+		last_update =
+			((partition_info_msg_t *) resp_msg.data)->last_update;
+		slurm_free_partition_info_msg(resp_msg.data);
+	}
+
+	slurm_mutex_lock(&replica_mutex);
+	xfree(rec->data);
+	rec->data_size = size_buf(resp_msg.buffer) - resp_msg.body_offset;
+	rec->data = xmalloc(rec->data_size);
+	memcpy(rec->data, get_buf_data(resp_msg.buffer) + resp_msg.body_offset,
+	       rec->data_size);
+	rec->fetch_time = time(NULL);
+	rec->last_update = last_update;
+	slurm_mutex_unlock(&replica_mutex);
+
+fini:	if (resp_msg.auth_cred)
+		g_slurm_auth_destroy(resp_msg.auth_cred);
+	free_buf(resp_msg.buffer);
+}
+
+/* _replica_fini - Stop refreshing replicas and release their memory */
+static void _replica_fini(void)
+{
+	int detail, type;
+
+	replica_stop = true;
+	if (replica_thread) {
+		pthread_join(replica_thread, NULL);
+		replica_thread = 0;
+	}
+
+	slurm_mutex_lock(&replica_mutex);
+	while (replica_thread_cnt)
+		slurm_cond_wait(&replica_cond, &replica_mutex);
+	for (type = 0; type < REPLICA_TYPE_CNT; type++) {
+		for (detail = 0; detail < 2; detail++) {
+			xfree(replica[type][detail].data);
+			memset(&replica[type][detail], 0, sizeof(replica_t));
+		}
+	}
+	slurm_mutex_unlock(&replica_mutex);
+}
+
+/*
+ * _replica_serve - Respond to a job, node or partition information request
+ *	from another thread, so that large responses do not hold up the RPCs
+ *	controlling the backup. Requests beyond REPLICA_THREADS at once are
+ *	refused.
+ * IN msg - request, its members and connection are released here
+ */
+static void _replica_serve(slurm_msg_t *msg)
+{
+	slurm_msg_t *thread_msg;
+
+	slurm_mutex_lock(&replica_mutex);
+	if (replica_stop || (replica_thread_cnt >= REPLICA_THREADS)) {
+		slurm_mutex_unlock(&replica_mutex);
+		debug2("Unable to serve RPC %s from replica, too busy",
+		       rpc_num2string(msg->msg_type));
+		slurm_send_rc_msg(msg, ESLURM_IN_STANDBY_MODE);
+		slurm_free_msg_members(msg);
+		close(msg->conn_fd);
+		return;
+	}
+	replica_thread_cnt++;
+	slurm_mutex_unlock(&replica_mutex);
+
+	thread_msg = xmalloc(sizeof(slurm_msg_t));
+	memcpy(thread_msg, msg, sizeof(slurm_msg_t));
+	slurm_thread_create_detached(NULL, _replica_serve_thread, thread_msg);
+}
+
+static void *_replica_serve_thread(void *arg)
+{
+	slurm_msg_t *msg = (slurm_msg_t *) arg;
+
+	if (_replica_send(msg) != SLURM_SUCCESS) {
+		debug2("Unable to serve RPC %s from replica",
+		       rpc_num2string(msg->msg_type));
+		slurm_send_rc_msg(msg, ESLURM_IN_STANDBY_MODE);
+	}
+	close(msg->conn_fd);
+	slurm_free_msg(msg);
+
+	return NULL;
+}
+
+/*
+ * _replica_send - Respond to a job, node or partition information request
+ *	from our replica of the primary controller's records. Only requests
+ *	with SHOW_REPLICA and SHOW_ALL set and records which are not private
+ *	are served, since the response must not depend upon the user.
+ *	The _replica_serve() slot of the calling thread is released before
+ *	sending, so that a slow client does not delay _replica_fini().
+ * RET SLURM_SUCCESS if a response was sent, otherwise an error code
+ */
+static int _replica_send(slurm_msg_t *msg)
+{
+	job_info_request_msg_t *job_req;
+	node_info_request_msg_t *node_req;
+	part_info_request_msg_t *part_req;
+	slurm_msg_t response_msg;
+	uint16_t private_data = 0, resp_type = 0, show_flags;
+	time_t last_update, now = time(NULL);
+	replica_t *rec;
+	char *dump = NULL;
+	int dump_size = 0, rc = ESLURM_IN_STANDBY_MODE, type;
+	/* Locks: Read configuration */
+	slurmctld_lock_t config_read_lock = {
+		READ_LOCK, NO_LOCK, NO_LOCK, NO_LOCK, NO_LOCK };
+
+	if (!msg->data || (msg->protocol_version != SLURM_PROTOCOL_VERSION))
+		goto release;
+
+	if (msg->msg_type == REQUEST_JOB_INFO) {
+		job_req = (job_info_request_msg_t *) msg->data;
+		if (job_req->job_ids || job_req->filter.accounts ||
+		    job_req->filter.partitions || job_req->filter.state_cnt ||
+		    job_req->filter.user_cnt)
+			goto release;
+		last_update = job_req->last_update;
+		show_flags = job_req->show_flags;
+		private_data = PRIVATE_DATA_JOBS;
+		resp_type = RESPONSE_JOB_INFO;
+		type = REPLICA_JOBS;
+	} else if (msg->msg_type == REQUEST_NODE_INFO) {
+		node_req = (node_info_request_msg_t *) msg->data;
+		last_update = node_req->last_update;
+		show_flags = node_req->show_flags;
+		private_data = PRIVATE_DATA_NODES;
+		resp_type = RESPONSE_NODE_INFO;
+		type = REPLICA_NODES;
+	} else {
+		part_req = (part_info_request_msg_t *) msg->data;
+		last_update = part_req->last_update;
+		show_flags = part_req->show_flags;
+		private_data = PRIVATE_DATA_PARTITIONS;
+		resp_type = RESPONSE_PARTITION_INFO;
+		type = REPLICA_PARTS;
+	}
+
+	if (!(show_flags & SHOW_REPLICA) || !(show_flags & SHOW_ALL))
+		goto release;
+	lock_slurmctld(config_read_lock);
+	private_data &= slurmctld_conf.private_data;
+	unlock_slurmctld(config_read_lock);
+	if (private_data)
+		goto release;
+
+	slurm_mutex_lock(&replica_mutex);
+	rec = &replica[type][(show_flags & SHOW_DETAIL) ? 1 : 0];
+	rec->last_request = now;
+	if (!rec->data ||
+	    (difftime(now, rec->fetch_time) > REPLICA_MAX_AGE)) {
+		rc = ESLURM_IN_STANDBY_MODE;
+	} else if (last_update >= rec->last_update) {
+		rc = SLURM_NO_CHANGE_IN_DATA;
+	} else {
+		dump_size = rec->data_size;
+		dump = xmalloc(dump_size);
+		memcpy(dump, rec->data, dump_size);
+		rc = SLURM_SUCCESS;
+	}
+	slurm_mutex_unlock(&replica_mutex);
+
+release:
+	slurm_mutex_lock(&replica_mutex);
+	replica_thread_cnt--;
+	slurm_cond_broadcast(&replica_cond);
+	slurm_mutex_unlock(&replica_mutex);
+
+	if (rc == SLURM_NO_CHANGE_IN_DATA) {
+		slurm_send_rc_msg(msg, rc);
+		return SLURM_SUCCESS;
+	}
+	if (rc != SLURM_SUCCESS)
+		return rc;
+
+	/* init response_msg structure */
+	slurm_msg_t_init(&response_msg);
+	response_msg.flags = msg->flags;
+	response_msg.protocol_version = msg->protocol_version;
+	response_msg.address = msg->address;
+	response_msg.conn = msg->conn;
+	response_msg.msg_type = resp_type;
+	response_msg.data = dump;
+	response_msg.data_size = dump_size;
+
+	/* send message */
+	slurm_send_node_msg(msg->conn_fd, &response_msg);
+	xfree(dump);
+
+	return SLURM_SUCCESS;
+}
+
 /*
  * Reload the slurm.conf parameters without any processing
  * of the node, partition, or state information.
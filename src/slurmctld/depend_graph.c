@@ -0,0 +1,136 @@
+/*****************************************************************************\
+ *  depend_graph.c - reverse job dependency graph
+ *****************************************************************************
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "src/common/macros.h"
+#include "src/common/strlcpy.h"
+#include "src/common/xhash.h"
+#include "src/common/xmalloc.h"
+
+#include "src/slurmctld/depend_graph.h"
+
+/* Reverse dependency graph record: the jobs which must have their
+ * dependencies tested again when job "job_id" changes state */
+typedef struct depend_graph_rec {
+	char key[16];		/* job_id as string, xhash key */
+	uint32_t *dep_ids;	/* sorted IDs of jobs depending upon job_id */
+	uint32_t dep_cnt;
+	uint32_t dep_size;
+} depend_graph_rec_t;
+
+static xhash_t *depend_graph = NULL;
+
+static const char *_depend_graph_id(void *item)
+{
+	depend_graph_rec_t *rec = (depend_graph_rec_t *) item;
+	return rec->key;
+}
+
+static void _depend_graph_free(void *item)
+{
+	depend_graph_rec_t *rec = (depend_graph_rec_t *) item;
+	xfree(rec->dep_ids);
+	xfree(rec);
+}
+
+extern void depend_graph_add(uint32_t job_id, uint32_t dep_job_id)
+{
+	depend_graph_rec_t *rec;
+	char key[16];
+	uint32_t lo, hi, mid;
+
+	if (!depend_graph) {
+		depend_graph = xhash_init(_depend_graph_id, _depend_graph_free,
+					  NULL, 0);
+	}
+
+	snprintf(key, sizeof(key), "%u", job_id);
+	if (!(rec = xhash_get(depend_graph, key))) {
+		rec = xmalloc(sizeof(depend_graph_rec_t));
+		strlcpy(rec->key, key, sizeof(rec->key));
+		xhash_add(depend_graph, rec);
+	}
+
+	/* Find the insertion point, return if already recorded */
+	lo = 0;
+	hi = rec->dep_cnt;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (rec->dep_ids[mid] == dep_job_id)
+			return;
+		if (rec->dep_ids[mid] < dep_job_id)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (rec->dep_cnt >= rec->dep_size) {
+		rec->dep_size = MAX(rec->dep_size * 2, 8);
+		xrealloc(rec->dep_ids, sizeof(uint32_t) * rec->dep_size);
+	}
+	memmove(rec->dep_ids + lo + 1, rec->dep_ids + lo,
+		sizeof(uint32_t) * (rec->dep_cnt - lo));
+	rec->dep_ids[lo] = dep_job_id;
+	rec->dep_cnt++;
+}
+
+extern uint32_t depend_graph_pop(uint32_t job_id,
+				 void (*func)(uint32_t dep_job_id, void *arg),
+				 void *arg)
+{
+	depend_graph_rec_t *rec;
+	char key[16];
+	uint32_t i, cnt;
+
+	if (!depend_graph)
+		return 0;
+
+	snprintf(key, sizeof(key), "%u", job_id);
+	if (!(rec = xhash_pop(depend_graph, key)))
+		return 0;
+	for (i = 0; i < rec->dep_cnt; i++)
+		(func)(rec->dep_ids[i], arg);
+	cnt = rec->dep_cnt;
+	_depend_graph_free(rec);
+
+	return cnt;
+}
+
+extern void depend_graph_fini(void)
+{
+	xhash_free_ptr(&depend_graph);
+}
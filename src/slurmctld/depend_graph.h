@@ -0,0 +1,58 @@
+/*****************************************************************************\
+ *  depend_graph.h - reverse job dependency graph
+ *****************************************************************************
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _SLURM_DEPEND_GRAPH_H
+#define _SLURM_DEPEND_GRAPH_H
+
+#include <inttypes.h>
+
+/*
+ * Record that job "dep_job_id" must have its dependencies tested again when
+ * job "job_id" changes state. Adding a pair which is already recorded has no
+ * effect, so a job may register again on every dependency test.
+ */
+extern void depend_graph_add(uint32_t job_id, uint32_t dep_job_id);
+
+/*
+ * Call "func" once for every job recorded as depending upon "job_id", then
+ * forget them.
+ * RET number of jobs passed to "func"
+ */
+extern uint32_t depend_graph_pop(uint32_t job_id,
+				 void (*func)(uint32_t dep_job_id, void *arg),
+				 void *arg);
+
+/* Free the reverse dependency graph, called at slurmctld shutdown */
+extern void depend_graph_fini(void);
+
+#endif /* !_SLURM_DEPEND_GRAPH_H */
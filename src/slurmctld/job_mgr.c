@@ -84,6 +84,7 @@
 #include "src/slurmctld/acct_policy.h"
 #include "src/slurmctld/agent.h"
 #include "src/slurmctld/burst_buffer.h"
+#include "src/slurmctld/depend_graph.h"
 #include "src/slurmctld/fed_mgr.h"
 #include "src/slurmctld/front_end.h"
 #include "src/slurmctld/gang.h"
@@ -126,6 +127,7 @@ typedef struct {
 
 typedef struct {
 	Buf       buffer;
+	job_info_filter_t *filter;
 	uint32_t  filter_uid;
 	uint32_t *jobs_packed;
 	uint16_t  protocol_version;
@@ -172,6 +174,8 @@ static int  _copy_job_desc_to_job_record(job_desc_msg_t * job_desc,
 static char *_copy_nodelist_no_dup(char *node_list);
 static struct job_record *_create_job_record(uint32_t num_jobs);
 static void _delete_job_details(struct job_record *job_entry);
+static void _delete_job_details_shared(struct job_details *details);
+static void _unshare_job_details(struct job_details *details);
 static void _del_batch_list_rec(void *x);
 static slurmdb_qos_rec_t *_determine_and_validate_qos(
 	char *resv_name, slurmdb_assoc_rec_t *assoc_ptr,
@@ -482,6 +486,79 @@ static struct job_record *_create_job_record(uint32_t num_jobs)
 }
 
 
+/*
+ * _delete_job_details_shared - release a job's reference to the details it
+ *	shares with other job array task records, freeing them with the last
+ *	reference, and clear the fields pointing to them
+ * IN details - job details to release the shared fields of
+ */
+static void _delete_job_details_shared(struct job_details *details)
+{
+	job_details_shared_t *shared = details->shared;
+	int i;
+
+	if (!shared)
+		return;
+
+	details->shared = NULL;
+	details->argc = 0;
+	details->argv = NULL;
+	details->ckpt_dir = NULL;
+	details->std_err = NULL;
+	details->std_in = NULL;
+	details->std_out = NULL;
+	details->work_dir = NULL;
+
+	if (--shared->ref_cnt)
+		return;
+
+	for (i = 0; i < shared->argc; i++)
+		xfree(shared->argv[i]);
+	xfree(shared->argv);
+	xfree(shared->ckpt_dir);
+	xfree(shared->std_err);
+	xfree(shared->std_in);
+	xfree(shared->std_out);
+	xfree(shared->work_dir);
+	xfree(shared);
+}
+
+/*
+ * _unshare_job_details - give a job private copies of the details it shares
+ *	with other job array task records, call before modifying any of them
+ * IN details - job details to take private copies of the shared fields in
+ */
+static void _unshare_job_details(struct job_details *details)
+{
+	job_details_shared_t copy;
+	int i;
+
+	if (!details->shared)
+		return;
+
+	/* Copy before releasing, this may be the last reference */
+	memcpy(&copy, details->shared, sizeof(job_details_shared_t));
+	if (copy.argv) {
+		copy.argv = xmalloc(sizeof(char *) * (copy.argc + 1));
+		for (i = 0; i < copy.argc; i++)
+			copy.argv[i] = xstrdup(details->shared->argv[i]);
+	}
+	copy.ckpt_dir = xstrdup(copy.ckpt_dir);
+	copy.std_err = xstrdup(copy.std_err);
+	copy.std_in = xstrdup(copy.std_in);
+	copy.std_out = xstrdup(copy.std_out);
+	copy.work_dir = xstrdup(copy.work_dir);
+	_delete_job_details_shared(details);
+
+	details->argc = copy.argc;
+	details->argv = copy.argv;
+	details->ckpt_dir = copy.ckpt_dir;
+	details->std_err = copy.std_err;
+	details->std_in = copy.std_in;
+	details->std_out = copy.std_out;
+	details->work_dir = copy.work_dir;
+}
+
 /*
  * _delete_job_details - delete a job's detail record and clear it's pointer
  * IN job_entry - pointer to job_record to clear the record of
@@ -506,6 +583,7 @@ static void _delete_job_details(struct job_record *job_entry)
 		list_enqueue(purge_files_list, job_id);
 	}
 
+	_delete_job_details_shared(job_entry->details);
 	xfree(job_entry->details->acctg_freq);
 	for (i=0; i<job_entry->details->argc; i++)
 		xfree(job_entry->details->argv[i]);
@@ -2657,6 +2735,7 @@ static int _load_job_details(struct job_record *job_ptr, Buf buffer,
 	}
 
 	/* free any left-over detail data */
+	_delete_job_details_shared(job_ptr->details);
 	xfree(job_ptr->details->acctg_freq);
 	for (i=0; i<job_ptr->details->argc; i++)
 		xfree(job_ptr->details->argv[i]);
@@ -4271,16 +4350,23 @@ extern struct job_record *job_array_split(struct job_record *job_ptr)
 
 	job_details = job_ptr->details;
 	details_new = job_ptr_pend->details;
+	/* Fields which rarely change after submission are shared with the
+	 * other tasks of this job array rather than copied */
+	if (!job_details->shared) {
+		job_details->shared = xmalloc(sizeof(job_details_shared_t));
+		job_details->shared->ref_cnt = 1;
+		job_details->shared->argc = job_details->argc;
+		job_details->shared->argv = job_details->argv;
+		job_details->shared->ckpt_dir = job_details->ckpt_dir;
+		job_details->shared->std_err = job_details->std_err;
+		job_details->shared->std_in = job_details->std_in;
+		job_details->shared->std_out = job_details->std_out;
+		job_details->shared->work_dir = job_details->work_dir;
+	}
+	job_details->shared->ref_cnt++;
 	memcpy(details_new, job_details, sizeof(struct job_details));
+	details_new->depend_rc = 0;	/* new job_id, not in depend graph */
 	details_new->acctg_freq = xstrdup(job_details->acctg_freq);
-	if (job_details->argc) {
-		details_new->argv =
-			xmalloc(sizeof(char *) * (job_details->argc + 1));
-		for (i = 0; i < job_details->argc; i++) {
-			details_new->argv[i] = xstrdup(job_details->argv[i]);
-		}
-	}
-	details_new->ckpt_dir = xstrdup(job_details->ckpt_dir);
 	details_new->cpu_bind = xstrdup(job_details->cpu_bind);
 	details_new->cpu_bind_type = job_details->cpu_bind_type;
 	details_new->cpu_freq_min = job_details->cpu_freq_min;
@@ -4319,10 +4405,6 @@ extern struct job_record *job_array_split(struct job_record *job_ptr)
 	}
 	details_new->req_nodes = xstrdup(job_details->req_nodes);
 	details_new->restart_dir = xstrdup(job_details->restart_dir);
-	details_new->std_err = xstrdup(job_details->std_err);
-	details_new->std_in = xstrdup(job_details->std_in);
-	details_new->std_out = xstrdup(job_details->std_out);
-	details_new->work_dir = xstrdup(job_details->work_dir);
 
 	if (job_ptr->fed_details)
 		add_fed_job_info(job_ptr);
@@ -8706,6 +8788,7 @@ static void _list_delete_job(void *job_entry)
 
 	/* Remove the record from job hash table */
 	_remove_job_hash(job_ptr);
+	depend_graph_job_event(job_ptr);
 
 	if (job_ptr->array_recs) {
 		job_array_size = MAX(1, job_ptr->array_recs->task_cnt);
@@ -8957,6 +9040,78 @@ static bool _hide_job(struct job_record *job_ptr, uid_t uid,
 	return false;
 }
 
+/* Return true if the name_len bytes at name are one of the comma separated
+ * names */
+static bool _name_in_list(char *names, char *name, int name_len,
+			  bool ignore_case)
+{
+	char *sep;
+	int len;
+
+	while (names) {
+		sep = strchr(names, ',');
+		len = sep ? (sep - names) : strlen(names);
+		if ((len == name_len) &&
+		    (ignore_case ? !strncasecmp(names, name, len) :
+				   !strncmp(names, name, len)))
+			return true;
+		names = sep ? (sep + 1) : NULL;
+	}
+	return false;
+}
+
+/* Return true if the job matches the filter, see job_info_filter_t */
+static bool _job_filter_match(struct job_record *job_ptr,
+			      job_info_filter_t *filter)
+{
+	uint32_t job_state, i;
+	char *part, *sep;
+	bool match;
+
+	if (filter->user_cnt) {
+		for (i = 0; i < filter->user_cnt; i++) {
+			if (filter->user_ids[i] == job_ptr->user_id)
+				break;
+		}
+		if (i >= filter->user_cnt)
+			return false;
+	}
+
+	if (filter->accounts &&
+	    (!job_ptr->account ||
+	     !_name_in_list(filter->accounts, job_ptr->account,
+			    strlen(job_ptr->account), true)))
+		return false;
+
+	if (filter->partitions) {
+		match = false;
+		for (part = job_ptr->partition; part && !match;
+		     part = sep ? (sep + 1) : NULL) {
+			sep = strchr(part, ',');
+			match = _name_in_list(filter->partitions, part,
+					      sep ? (sep - part) : strlen(part),
+					      false);
+		}
+		if (!match)
+			return false;
+	}
+
+	if (filter->state_cnt) {
+		job_state = job_ptr->job_state & (~JOB_UPDATE_DB);
+		for (i = 0; i < filter->state_cnt; i++) {
+			if (filter->states[i] & JOB_STATE_FLAGS) {
+				if (filter->states[i] & job_state)
+					break;
+			} else if (filter->states[i] == job_state)
+				break;
+		}
+		if (i >= filter->state_cnt)
+			return false;
+	}
+
+	return true;
+}
+
 static void _pack_job(struct job_record *job_ptr,
 		      _foreach_pack_job_info_t *pack_info)
 {
@@ -8974,6 +9129,9 @@ static void _pack_job(struct job_record *job_ptr,
 	    (pack_info->filter_uid != job_ptr->user_id))
 		return;
 
+	if (pack_info->filter && !_job_filter_match(job_ptr, pack_info->filter))
+		return;
+
 	pack_job(job_ptr, pack_info->show_flags, pack_info->buffer,
 		 pack_info->protocol_version, pack_info->uid);
 
@@ -9011,6 +9169,7 @@ static int _foreach_pack_jobid(void *object, void *arg)
  * IN show_flags - job filtering options
  * IN uid - uid of user making request (for partition filtering)
  * IN filter_uid - pack only jobs belonging to this user if not NO_VAL
+ * IN filter - pack only jobs matching this filter if not NULL
  * global: job_list - global list of job records
  * NOTE: the buffer at *buffer_ptr must be xfreed by the caller
  * NOTE: change _unpack_job_desc_msg() in common/slurm_protocol_pack.c
@@ -9018,6 +9177,7 @@ static int _foreach_pack_jobid(void *object, void *arg)
  */
 extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
 			  uint16_t show_flags, uid_t uid, uint32_t filter_uid,
+			  job_info_filter_t *filter,
 			  uint16_t protocol_version)
 {
 	uint32_t jobs_packed = 0, tmp_offset;
@@ -9036,6 +9196,7 @@ extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
 
 	/* write individual job records */
 	pack_info.buffer           = buffer;
+	pack_info.filter           = filter;
 	pack_info.filter_uid       = filter_uid;
 	pack_info.jobs_packed      = &jobs_packed;
 	pack_info.protocol_version = protocol_version;
@@ -9063,6 +9224,7 @@ extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
  * IN job_ids - list of job_ids to pack
  * IN uid - uid of user making request (for partition filtering)
  * IN filter_uid - pack only jobs belonging to this user if not NO_VAL
+ * IN filter - pack only jobs matching this filter if not NULL
  * global: job_list - global list of job records
  * NOTE: the buffer at *buffer_ptr must be xfreed by the caller
  * NOTE: change _unpack_job_desc_msg() in common/slurm_protocol_pack.c
@@ -9070,6 +9232,7 @@ extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
  */
 extern void pack_spec_jobs(char **buffer_ptr, int *buffer_size, List job_ids,
 			   uint16_t show_flags, uid_t uid, uint32_t filter_uid,
+			   job_info_filter_t *filter,
 			   uint16_t protocol_version)
 {
 	uint32_t jobs_packed = 0, tmp_offset;
@@ -9090,6 +9253,7 @@ extern void pack_spec_jobs(char **buffer_ptr, int *buffer_size, List job_ids,
 
 	/* write individual job records */
 	pack_info.buffer           = buffer;
+	pack_info.filter           = filter;
 	pack_info.filter_uid       = filter_uid;
 	pack_info.jobs_packed      = &jobs_packed;
 	pack_info.protocol_version = protocol_version;
@@ -12236,6 +12400,7 @@ static int _update_job(struct job_record *job_ptr, job_desc_msg_t * job_specs,
 		if (!IS_JOB_PENDING(job_ptr))
 			error_code = ESLURM_JOB_NOT_PENDING;
 		else if (detail_ptr) {
+			_unshare_job_details(detail_ptr);
 			xfree(detail_ptr->std_out);
 			detail_ptr->std_out = xstrdup(job_specs->std_out);
 		}
@@ -14084,6 +14249,7 @@ void batch_requeue_fini(struct job_record  *job_ptr)
 /* job_fini - free all memory associated with job records */
 void job_fini (void)
 {
+	depend_graph_fini();
 	FREE_NULL_LIST(job_list);
 	xfree(job_hash);
 	xfree(job_array_hash_j);
@@ -14173,6 +14339,7 @@ extern void job_completion_logger(struct job_record *job_ptr, bool requeue)
 	xassert(job_ptr);
 
 	acct_policy_remove_job_submit(job_ptr);
+	depend_graph_job_event(job_ptr);
 	if (job_ptr->nodes &&  ((job_ptr->bit_flags & JOB_KILL_HURRY) == 0)) {
 		(void) bb_g_job_start_stage_out(job_ptr);
 	} else {
@@ -16679,6 +16846,7 @@ extern bool job_hold_requeue(struct job_record *job_ptr)
 	}
 
 	job_ptr->job_state &= ~JOB_REQUEUE;
+	depend_graph_job_event(job_ptr);
 
 	debug("%s: job %u state 0x%x reason %u priority %d", __func__,
 	      job_ptr->job_id, job_ptr->job_state,
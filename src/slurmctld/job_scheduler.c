@@ -75,6 +75,7 @@
 #include "src/slurmctld/acct_policy.h"
 #include "src/slurmctld/agent.h"
 #include "src/slurmctld/burst_buffer.h"
+#include "src/slurmctld/depend_graph.h"
 #include "src/slurmctld/fed_mgr.h"
 #include "src/slurmctld/front_end.h"
 #include "src/slurmctld/gang.h"
@@ -105,12 +106,24 @@ typedef struct epilog_arg {
 	char **my_env;
 } epilog_arg_t;
 
+/* Array based binary heap of job:partition pairs used by _schedule(). The
+ * records array is kept between scheduling passes so that it is normally
+ * only grown, never freed and reallocated. */
+typedef struct job_heap {
+	job_queue_rec_t *recs;
+	uint32_t cnt;
+	uint32_t size;
+} job_heap_t;
+
 static char **	_build_env(struct job_record *job_ptr, bool is_epilog);
 static batch_job_launch_msg_t *_build_launch_job_msg(struct job_record *job_ptr,
 						     uint16_t protocol_version);
 static void	_depend_list_del(void *dep_ptr);
 static void	_feature_list_delete(void *x);
-static void	_job_queue_append(List job_queue, struct job_record *job_ptr,
+static void	_build_job_queue(bool clear_start, bool backfill,
+				 List job_queue, job_heap_t *job_heap);
+static void	_job_queue_append(List job_queue, job_heap_t *job_heap,
+				  struct job_record *job_ptr,
 				  struct part_record *part_ptr, uint32_t priority);
 static void	_job_queue_rec_del(void *x);
 static bool	_job_runnable_test1(struct job_record *job_ptr,
@@ -143,6 +156,7 @@ static int sched_min_interval = 2;
 #endif
 
 static int bb_array_stage_cnt = 10;
+static job_heap_t sched_job_heap = { NULL, 0, 0 };
 extern diag_stats_t slurmctld_diag_stats;
 
 /*
@@ -226,11 +240,30 @@ static List _build_user_job_list(uint32_t user_id, char* job_name)
 	return job_queue;
 }
 
-static void _job_queue_append(List job_queue, struct job_record *job_ptr,
+/* Add a job:partition pair to either job_queue or job_heap (whichever is
+ * not NULL). Records added to job_heap are not ordered until
+ * _job_heap_init() is called. */
+static void _job_queue_append(List job_queue, job_heap_t *job_heap,
+			      struct job_record *job_ptr,
 			      struct part_record *part_ptr, uint32_t prio)
 {
 	job_queue_rec_t *job_queue_rec;
 
+	if (job_heap) {
+		if (job_heap->cnt >= job_heap->size) {
+			job_heap->size = MAX(job_heap->size * 2, 1024);
+			xrealloc(job_heap->recs,
+				 sizeof(job_queue_rec_t) * job_heap->size);
+		}
+		job_queue_rec = &job_heap->recs[job_heap->cnt++];
+		job_queue_rec->array_task_id = job_ptr->array_task_id;
+		job_queue_rec->job_id   = job_ptr->job_id;
+		job_queue_rec->job_ptr  = job_ptr;
+		job_queue_rec->part_ptr = part_ptr;
+		job_queue_rec->priority = prio;
+		return;
+	}
+
 	job_queue_rec = xmalloc(sizeof(job_queue_rec_t));
 	job_queue_rec->array_task_id = job_ptr->array_task_id;
 	job_queue_rec->job_id   = job_ptr->job_id;
@@ -245,6 +278,58 @@ static void _job_queue_rec_del(void *x)
 	xfree(x);
 }
 
+/* Return true if heap record a must be scheduled before record b */
+static bool _job_heap_before(job_queue_rec_t *a, job_queue_rec_t *b)
+{
+	return (sort_job_queue2(&a, &b) < 0);
+}
+
+static void _job_heap_sift_down(job_heap_t *job_heap, uint32_t inx)
+{
+	job_queue_rec_t tmp_rec;
+	uint32_t child;
+
+	while ((child = (inx * 2) + 1) < job_heap->cnt) {
+		if (((child + 1) < job_heap->cnt) &&
+		    _job_heap_before(&job_heap->recs[child + 1],
+				     &job_heap->recs[child]))
+			child++;
+		if (!_job_heap_before(&job_heap->recs[child],
+				      &job_heap->recs[inx]))
+			break;
+		tmp_rec = job_heap->recs[inx];
+		job_heap->recs[inx] = job_heap->recs[child];
+		job_heap->recs[child] = tmp_rec;
+		inx = child;
+	}
+}
+
+/* Order the records appended to job_heap, O(n) */
+static void _job_heap_init(job_heap_t *job_heap)
+{
+	uint32_t inx;
+
+	for (inx = job_heap->cnt / 2; inx > 0; inx--)
+		_job_heap_sift_down(job_heap, inx - 1);
+}
+
+/* Remove the highest priority record from job_heap, O(log n)
+ * OUT job_queue_rec - copy of the record removed
+ * RET false if job_heap is empty */
+static bool _job_heap_pop(job_heap_t *job_heap, job_queue_rec_t *job_queue_rec)
+{
+	if (job_heap->cnt == 0)
+		return false;
+
+	*job_queue_rec = job_heap->recs[0];
+	job_heap->cnt--;
+	if (job_heap->cnt) {
+		job_heap->recs[0] = job_heap->recs[job_heap->cnt];
+		_job_heap_sift_down(job_heap, 0);
+	}
+	return true;
+}
+
 /* Return true if the job has some step still in a cleaning state, which
  * can happen on a Cray if a job is requeued and the step NHC is still running
  * after the requeued job is eligible to run again */
@@ -377,9 +462,22 @@ static bool _job_runnable_test2(struct job_record *job_ptr, bool check_min_time)
  * NOTE: the caller must call FREE_NULL_LIST() on RET value to free memory
  */
 extern List build_job_queue(bool clear_start, bool backfill)
+{
+	List job_queue = list_create(_job_queue_rec_del);
+
+	_build_job_queue(clear_start, backfill, job_queue, NULL);
+
+	return job_queue;
+}
+
+/*
+ * _build_job_queue - add pending job:partition pairs to either job_queue or
+ *	job_heap, see build_job_queue() for argument details
+ */
+static void _build_job_queue(bool clear_start, bool backfill,
+			     List job_queue, job_heap_t *job_heap)
 {
 	static time_t last_log_time = 0;
-	List job_queue;
 	ListIterator depend_iter, job_iterator, part_iterator;
 	struct job_record *job_ptr = NULL, *new_job_ptr;
 	struct part_record *part_ptr;
@@ -393,7 +491,6 @@ extern List build_job_queue(bool clear_start, bool backfill)
 
 	/* init the timer */
 	(void) slurm_delta_tv(&start_tv);
-	job_queue = list_create(_job_queue_rec_del);
 
 	/* Create individual job records for job arrays that need burst buffer
 	 * staging */
@@ -535,13 +632,13 @@ extern List build_job_queue(bool clear_start, bool backfill)
 					continue;
 				job_part_pairs++;
 				if (job_ptr->priority_array) {
-					_job_queue_append(job_queue, job_ptr,
-							  part_ptr,
+					_job_queue_append(job_queue, job_heap,
+							  job_ptr, part_ptr,
 							  job_ptr->
 							  priority_array[inx]);
 				} else {
-					_job_queue_append(job_queue, job_ptr,
-							  part_ptr,
+					_job_queue_append(job_queue, job_heap,
+							  job_ptr, part_ptr,
 							  job_ptr->priority);
 				}
 			}
@@ -563,13 +660,11 @@ extern List build_job_queue(bool clear_start, bool backfill)
 			if (!_job_runnable_test2(job_ptr, backfill))
 				continue;
 			job_part_pairs++;
-			_job_queue_append(job_queue, job_ptr,
+			_job_queue_append(job_queue, job_heap, job_ptr,
 					  job_ptr->part_ptr, job_ptr->priority);
 		}
 	}
 	list_iterator_destroy(job_iterator);
-
-	return job_queue;
 }
 
 /*
@@ -1182,11 +1277,10 @@ extern bool deadline_ok(struct job_record *job_ptr, char *func)
 static int _schedule(uint32_t job_limit)
 {
 	ListIterator job_iterator = NULL, part_iterator = NULL;
-	List job_queue = NULL;
 	int failed_part_cnt = 0, failed_resv_cnt = 0, job_cnt = 0;
 	int error_code, i, j, part_cnt, time_limit, pend_time;
 	uint32_t job_depth = 0, array_task_id;
-	job_queue_rec_t *job_queue_rec;
+	job_queue_rec_t job_queue_rec;
 	struct job_record *job_ptr = NULL;
 	struct part_record *part_ptr, **failed_parts = NULL;
 	struct part_record *skip_part_ptr = NULL;
@@ -1485,6 +1579,7 @@ static int _schedule(uint32_t job_limit)
 	}
 #endif
 
+	acct_policy_cycle_begin();
 	part_cnt = list_count(part_list);
 	failed_parts = xmalloc(sizeof(struct part_record *) * part_cnt);
 	failed_resv = xmalloc(sizeof(struct slurmctld_resv*) * MAX_FAILED_RESV);
@@ -1558,9 +1653,12 @@ static int _schedule(uint32_t job_limit)
 		slurmctld_diag_stats.schedule_queue_len = list_count(job_list);
 		job_iterator = list_iterator_create(job_list);
 	} else {
-		job_queue = build_job_queue(false, false);
-		slurmctld_diag_stats.schedule_queue_len = list_count(job_queue);
-		sort_job_queue(job_queue);
+		/* Only the records actually considered (job_limit,
+		 * default_queue_depth, etc.) need to be fully ordered */
+		sched_job_heap.cnt = 0;
+		_build_job_queue(false, false, NULL, &sched_job_heap);
+		slurmctld_diag_stats.schedule_queue_len = sched_job_heap.cnt;
+		_job_heap_init(&sched_job_heap);
 	}
 	while (1) {
 		if (fifo_sched) {
@@ -1598,14 +1696,12 @@ next_part:			part_ptr = (struct part_record *)
 					continue;
 			}
 		} else {
-			job_queue_rec = list_pop(job_queue);
-			if (!job_queue_rec)
+			if (!_job_heap_pop(&sched_job_heap, &job_queue_rec))
 				break;
-			array_task_id = job_queue_rec->array_task_id;
-			job_ptr  = job_queue_rec->job_ptr;
-			part_ptr = job_queue_rec->part_ptr;
-			job_ptr->priority = job_queue_rec->priority;
-			xfree(job_queue_rec);
+			array_task_id = job_queue_rec.array_task_id;
+			job_ptr  = job_queue_rec.job_ptr;
+			part_ptr = job_queue_rec.part_ptr;
+			job_ptr->priority = job_queue_rec.priority;
 			if (!avail_front_end(job_ptr)) {
 				job_ptr->state_reason = WAIT_FRONT_END;
 				xfree(job_ptr->state_desc);
@@ -2124,8 +2220,8 @@ fail_this_part:	if (fail_by_part) {
 			list_iterator_destroy(job_iterator);
 		if (part_iterator)
 			list_iterator_destroy(part_iterator);
-	} else if (job_queue) {
-		FREE_NULL_LIST(job_queue);
+	} else {
+		sched_job_heap.cnt = 0;
 	}
 	xfree(sched_part_ptr);
 	xfree(sched_part_jobs);
@@ -2135,6 +2231,7 @@ fail_this_part:	if (fail_by_part) {
 		     "configuring max_rpc_cnt",
 		     slurmctld_config.server_thread_count);
 	}
+	acct_policy_cycle_end();
 	unlock_slurmctld(job_write_lock);
 	END_TIMER2("schedule");
 
@@ -2904,6 +3001,29 @@ static void _depend_list2str(struct job_record *job_ptr, bool set_or_flag)
 	list_iterator_destroy(depend_iter);
 }
 
+/* Invalidate the cached dependency state of a job depending upon a job which
+ * changed state. It is added back on its next dependency test. */
+static void _depend_graph_notify(uint32_t dep_job_id, void *arg)
+{
+	struct job_record *dep_job_ptr = find_job_record(dep_job_id);
+
+	if (dep_job_ptr && dep_job_ptr->details)
+		dep_job_ptr->details->depend_rc = 0;
+}
+
+/*
+ * Note that a job started, ended, was requeued or purged, so that jobs
+ * depending upon it (or upon its job array) have their dependencies tested
+ * again by test_job_dependency()
+ */
+extern void depend_graph_job_event(struct job_record *job_ptr)
+{
+	(void) depend_graph_pop(job_ptr->job_id, _depend_graph_notify, NULL);
+	if (job_ptr->array_job_id && (job_ptr->array_job_id != job_ptr->job_id))
+		(void) depend_graph_pop(job_ptr->array_job_id,
+					_depend_graph_notify, NULL);
+}
+
 /*
  * Determine if a job's dependencies are met
  * RET: 0 = no dependencies
@@ -2915,7 +3035,7 @@ extern int test_job_dependency(struct job_record *job_ptr)
 	ListIterator depend_iter, job_iterator;
 	struct depend_spec *dep_ptr;
 	bool failure = false, depends = false, rebuild_str = false;
-	bool or_satisfied = false;
+	bool or_satisfied = false, cache_rc = true;
  	List job_queue = NULL;
  	bool run_now;
 	int results = 0;
@@ -2926,12 +3046,23 @@ extern int test_job_dependency(struct job_record *job_ptr)
 	    (list_count(job_ptr->details->depend_list) == 0))
 		return 0;
 
+	/* Nothing this job depends upon changed state since the last test */
+	if (job_ptr->details->depend_rc)
+		return job_ptr->details->depend_rc;
+
 	depend_iter = list_iterator_create(job_ptr->details->depend_list);
 	while ((dep_ptr = list_next(depend_iter))) {
 		bool clear_dep = false;
 		dep_ptr->job_ptr = find_job_array_rec(dep_ptr->job_id,
 						      dep_ptr->array_task_id);
 		djob_ptr = dep_ptr->job_ptr;
+		/* Singleton and expand dependencies are not (only) functions
+		 * of the state of job_id and must be tested every time */
+		if ((dep_ptr->depend_type == SLURM_DEPEND_SINGLETON) ||
+		    (dep_ptr->depend_type == SLURM_DEPEND_EXPAND))
+			cache_rc = false;
+		else
+			depend_graph_add(dep_ptr->job_id, job_ptr->job_id);
  		if ((dep_ptr->depend_type == SLURM_DEPEND_SINGLETON) &&
  		    job_ptr->name) {
  			/* get user jobs with the same user and name */
@@ -3114,6 +3245,8 @@ extern int test_job_dependency(struct job_record *job_ptr)
 		results = 2;
 	else if (depends)
 		results = 1;
+	if (cache_rc)
+		job_ptr->details->depend_rc = results;
 
 	return results;
 }
@@ -3436,6 +3569,7 @@ extern int update_job_dependency(struct job_record *job_ptr, char *new_depend)
 	if (rc == SLURM_SUCCESS) {
 		FREE_NULL_LIST(job_ptr->details->depend_list);
 		job_ptr->details->depend_list = new_depend_list;
+		job_ptr->details->depend_rc = 0;
 		_depend_list2str(job_ptr, or_flag);
 #if _DEBUG
 		print_job_dependency(job_ptr);
@@ -209,6 +209,13 @@ extern void sort_job_queue(List job_queue);
  *	in order of decreasing priority */
 extern int sort_job_queue2(void *x, void *y);
 
+/*
+ * Note that a job started, ended, was requeued or purged, so that jobs
+ * depending upon it (or upon its job array) have their dependencies tested
+ * again by test_job_dependency()
+ */
+extern void depend_graph_job_event(struct job_record *job_ptr);
+
 /*
  * Determine if a job's dependencies are met
  * RET: 0 = no dependencies
@@ -86,6 +86,27 @@
 /* No need to change we always pack SLURM_PROTOCOL_VERSION */
 #define NODE_STATE_VERSION        "PROTOCOL_VERSION"
 
+/* Seconds a node snapshot may be reused, bounding the age of values such as
+ * energy which are updated without changing last_node_update */
+#define NODE_SNAPSHOT_MAX_AGE	2
+
+/* Node records packed by _pack_node() for SLURM_PROTOCOL_VERSION */
+typedef struct {
+	Buf buffer;		/* packed node records */
+	time_t build_time;	/* time when packed */
+	uint32_t *name_end;	/* offset after each record's node name */
+	int node_cnt;		/* count of node records */
+	uint32_t *offset;	/* offset of each record, node_cnt + 1 */
+	int ref_cnt;		/* count of node_snapshot_ref_t using this */
+	time_t version;		/* last_node_update when packed */
+} node_snapshot_t;
+
+struct node_snapshot_ref {
+	bitstr_t *hidden;	/* nodes to pack without a name */
+	uint32_t node_scaling;
+	node_snapshot_t *snap;
+};
+
 /* Global variables */
 bitstr_t *avail_node_bitmap = NULL;	/* bitmap of available nodes */
 bitstr_t *booting_node_bitmap = NULL;	/* bitmap of booting nodes */
@@ -95,10 +116,15 @@ bitstr_t *power_node_bitmap = NULL;	/* bitmap of powered down nodes */
 bitstr_t *share_node_bitmap = NULL;  	/* bitmap of sharable nodes */
 bitstr_t *up_node_bitmap    = NULL;  	/* bitmap of non-down nodes */
 
+static pthread_mutex_t node_snap_mutex = PTHREAD_MUTEX_INITIALIZER;
+static node_snapshot_t *node_snap[2] = { NULL, NULL };	/* by SHOW_DETAIL */
+
 static void 	_dump_node_state (struct node_record *dump_node_ptr,
 				  Buf buffer);
 static front_end_record_t * _front_end_reg(
 				slurm_node_registration_status_msg_t *reg_msg);
+static bool	_hide_node(struct node_record *node_ptr, uint16_t show_flags,
+			   uid_t uid);
 static bool	_is_cloud_hidden(struct node_record *node_ptr);
 static void 	_make_node_down(struct node_record *node_ptr,
 				time_t event_time);
@@ -796,7 +822,6 @@ extern void pack_all_node (char **buffer_ptr, int *buffer_size,
 	Buf buffer;
 	time_t now = time(NULL);
 	struct node_record *node_ptr = node_record_table_ptr;
-	bool hidden;
 
 	xassert(verify_lock(CONFIG_LOCK, READ_LOCK));
 	xassert(verify_lock(PART_LOCK, READ_LOCK));
@@ -826,19 +851,7 @@ extern void pack_all_node (char **buffer_ptr, int *buffer_size,
 			 * the node index pointers. So pack a node
 			 * with a name of NULL and let the caller deal
 			 * with it. */
-			hidden = false;
-			if (((show_flags & SHOW_ALL) == 0) && (uid != 0) &&
-			    (_node_is_hidden(node_ptr, uid)))
-				hidden = true;
-			else if (IS_NODE_FUTURE(node_ptr))
-				hidden = true;
-			else if (_is_cloud_hidden(node_ptr))
-				hidden = true;
-			else if ((node_ptr->name == NULL) ||
-				 (node_ptr->name[0] == '\0'))
-				hidden = true;
-
-			if (hidden) {
+			if (_hide_node(node_ptr, show_flags, uid)) {
 				char *orig_name = node_ptr->name;
 				node_ptr->name = NULL;
 				_pack_node(node_ptr, buffer, protocol_version,
@@ -864,6 +877,160 @@ extern void pack_all_node (char **buffer_ptr, int *buffer_size,
 	buffer_ptr[0] = xfer_buf_data (buffer);
 }
 
+/* Return true if pack_all_node() should pack the node without its name */
+static bool _hide_node(struct node_record *node_ptr, uint16_t show_flags,
+		       uid_t uid)
+{
+	if (((show_flags & SHOW_ALL) == 0) && (uid != 0) &&
+	    (_node_is_hidden(node_ptr, uid)))
+		return true;
+	if (IS_NODE_FUTURE(node_ptr))
+		return true;
+	if (_is_cloud_hidden(node_ptr))
+		return true;
+	if ((node_ptr->name == NULL) || (node_ptr->name[0] == '\0'))
+		return true;
+	return false;
+}
+
+static void _node_snapshot_free(node_snapshot_t *snap)
+{
+	free_buf(snap->buffer);
+	xfree(snap->name_end);
+	xfree(snap->offset);
+	xfree(snap);
+}
+
+static node_snapshot_t *_node_snapshot_build(uint16_t show_flags)
+{
+	node_snapshot_t *snap = xmalloc(sizeof(node_snapshot_t));
+	struct node_record *node_ptr = node_record_table_ptr;
+	uint32_t name_len;
+	int inx;
+
+	snap->buffer = init_buf(BUF_SIZE * 16);
+	snap->build_time = time(NULL);
+	snap->version = last_node_update;
+	snap->node_cnt = node_record_count;
+	snap->name_end = xmalloc(sizeof(uint32_t) * (node_record_count + 1));
+	snap->offset = xmalloc(sizeof(uint32_t) * (node_record_count + 1));
+	for (inx = 0; inx < node_record_count; inx++, node_ptr++) {
+		snap->offset[inx] = get_buf_offset(snap->buffer);
+		/* Name is packed first by packstr() */
+		name_len = node_ptr->name ? (strlen(node_ptr->name) + 1) : 0;
+		snap->name_end[inx] = snap->offset[inx] + sizeof(uint32_t) +
+				      name_len;
+		_pack_node(node_ptr, snap->buffer, SLURM_PROTOCOL_VERSION,
+			   show_flags);
+	}
+	snap->offset[inx] = get_buf_offset(snap->buffer);
+
+	return snap;
+}
+
+/*
+ * get_node_snapshot - reference packed node records for a pack_all_node()
+ *	style reply, repacking them only when the node table has changed
+ * IN show_flags - node filtering options
+ * IN uid - uid of user making request (for partition filtering)
+ * IN protocol_version - slurm protocol version of client
+ * RET reference to pass to pack_node_snapshot() or NULL if protocol_version
+ *	is not current, in which case pack_all_node() must be used
+ */
+extern node_snapshot_ref_t *get_node_snapshot(uint16_t show_flags, uid_t uid,
+					      uint16_t protocol_version)
+{
+	node_snapshot_ref_t *snap_ref;
+	node_snapshot_t *snap;
+	struct node_record *node_ptr = node_record_table_ptr;
+	time_t now = time(NULL);
+	int detail = (show_flags & SHOW_DETAIL) ? 1 : 0;
+	int inx;
+
+	xassert(verify_lock(CONFIG_LOCK, READ_LOCK));
+	xassert(verify_lock(NODE_LOCK, READ_LOCK));
+	xassert(verify_lock(PART_LOCK, READ_LOCK));
+
+	if (protocol_version != SLURM_PROTOCOL_VERSION)
+		return NULL;
+
+	slurm_mutex_lock(&node_snap_mutex);
+	snap = node_snap[detail];
+	/* Changes later in the second the snapshot was built in keep the
+	 * same last_node_update, so such a snapshot is never reused */
+	if (!snap || (snap->version != last_node_update) ||
+	    (snap->build_time <= snap->version) ||
+	    (snap->node_cnt != node_record_count) ||
+	    ((now - snap->build_time) > NODE_SNAPSHOT_MAX_AGE)) {
+		if (snap && (snap->ref_cnt == 0))
+			_node_snapshot_free(snap);
+		snap = _node_snapshot_build(show_flags);
+		node_snap[detail] = snap;
+	}
+	snap->ref_cnt++;
+	slurm_mutex_unlock(&node_snap_mutex);
+
+	snap_ref = xmalloc(sizeof(node_snapshot_ref_t));
+	snap_ref->snap = snap;
+	snap_ref->hidden = bit_alloc(node_record_count + 1);
+	select_g_alter_node_cnt(SELECT_GET_NODE_SCALING,
+				&snap_ref->node_scaling);
+	for (inx = 0; inx < node_record_count; inx++, node_ptr++) {
+		if (_hide_node(node_ptr, show_flags, uid))
+			bit_set(snap_ref->hidden, inx);
+	}
+
+	return snap_ref;
+}
+
+/*
+ * pack_node_snapshot - build a pack_all_node() style reply from a node
+ *	snapshot reference and release the reference. No locks are needed.
+ * IN snap_ref - reference from get_node_snapshot()
+ * OUT buffer_ptr - pointer to the stored data
+ * OUT buffer_size - set to size of the buffer in bytes
+ * NOTE: the caller must xfree the buffer at *buffer_ptr
+ */
+extern void pack_node_snapshot(node_snapshot_ref_t *snap_ref,
+			       char **buffer_ptr, int *buffer_size)
+{
+	node_snapshot_t *snap = snap_ref->snap;
+	char *data = get_buf_data(snap->buffer);
+	uint32_t *offset = snap->offset;
+	Buf buffer;
+	int inx, run_start = 0;
+
+	buffer = init_buf(offset[snap->node_cnt] + BUF_SIZE);
+	pack32(snap->node_cnt, buffer);
+	pack32(snap_ref->node_scaling, buffer);
+	pack_time(time(NULL), buffer);
+
+	/* Copy runs of visible records, hidden ones without their name */
+	for (inx = 0; inx < snap->node_cnt; inx++) {
+		if (!bit_test(snap_ref->hidden, inx))
+			continue;
+		packmem_array(data + offset[run_start],
+			      offset[inx] - offset[run_start], buffer);
+		pack32(0, buffer);
+		packmem_array(data + snap->name_end[inx],
+			      offset[inx + 1] - snap->name_end[inx], buffer);
+		run_start = inx + 1;
+	}
+	packmem_array(data + offset[run_start],
+		      offset[snap->node_cnt] - offset[run_start], buffer);
+
+	slurm_mutex_lock(&node_snap_mutex);
+	if ((--snap->ref_cnt == 0) &&
+	    (snap != node_snap[0]) && (snap != node_snap[1]))
+		_node_snapshot_free(snap);
+	slurm_mutex_unlock(&node_snap_mutex);
+	FREE_NULL_BITMAP(snap_ref->hidden);
+	xfree(snap_ref);
+
+	*buffer_size = get_buf_offset(buffer);
+	buffer_ptr[0] = xfer_buf_data(buffer);
+}
+
 /*
  * pack_one_node - dump all configuration and node information for one node
  *	in machine independent form (for network transmission)
@@ -3843,6 +4010,8 @@ extern int send_nodes_to_accounting(time_t event_time)
 /* node_fini - free all memory associated with node records */
 extern void node_fini (void)
 {
+	int i;
+
 	FREE_NULL_LIST(active_feature_list);
 	FREE_NULL_LIST(avail_feature_list);
 	FREE_NULL_BITMAP(avail_node_bitmap);
@@ -3852,6 +4021,15 @@ extern void node_fini (void)
 	FREE_NULL_BITMAP(power_node_bitmap);
 	FREE_NULL_BITMAP(share_node_bitmap);
 	FREE_NULL_BITMAP(up_node_bitmap);
+
+	slurm_mutex_lock(&node_snap_mutex);
+	for (i = 0; i < 2; i++) {
+		if (node_snap[i] && (node_snap[i]->ref_cnt == 0))
+			_node_snapshot_free(node_snap[i]);
+		node_snap[i] = NULL;
+	}
+	slurm_mutex_unlock(&node_snap_mutex);
+
 	node_fini2();
 }
 
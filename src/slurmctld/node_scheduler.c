@@ -2581,6 +2581,7 @@ extern int select_nodes(struct job_record *job_ptr, bool test_only,
 
 	allocate_nodes(job_ptr);
 	job_array_start(job_ptr);
+	depend_graph_job_event(job_ptr);
 	build_node_details(job_ptr, true);
 	rebuild_job_part_list(job_ptr);
 
@@ -103,6 +103,18 @@
 /* Delay start of pack job until all components are recorded */
 #define PACK_DELAY 2
 
+/* Maximum node registrations applied under one slurmctld lock */
+#define NODE_REG_BATCH_MAX 256
+
+/* Node registration waiting to be applied, see _node_reg_batch() */
+typedef struct node_reg_req {
+	bool done;
+	int error_code;
+	slurm_msg_t *msg;
+	bool newly_up;
+	struct node_reg_req *next;
+} node_reg_req_t;
+
 static pthread_mutex_t rpc_mutex = PTHREAD_MUTEX_INITIALIZER;
 static int rpc_type_size = 0;	/* Size of rpc_type_* arrays */
 static uint16_t *rpc_type_id = NULL;
@@ -116,6 +128,12 @@ static uint64_t *rpc_user_time = NULL;
 static pthread_mutex_t throttle_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t throttle_cond = PTHREAD_COND_INITIALIZER;
 
+static pthread_mutex_t node_reg_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t node_reg_cond = PTHREAD_COND_INITIALIZER;
+static node_reg_req_t *node_reg_head = NULL;
+static node_reg_req_t *node_reg_tail = NULL;
+static bool node_reg_busy = false;
+
 static void         _fill_ctld_conf(slurm_ctl_conf_t * build_ptr);
 static void         _kill_job_on_msg_fail(uint32_t job_id);
 static int          _is_prolog_finished(uint32_t job_id);
@@ -1663,11 +1681,13 @@ static void _slurm_rpc_dump_jobs(slurm_msg_t * msg)
 			pack_spec_jobs(&dump, &dump_size,
 				       job_info_request_msg->job_ids,
 				       job_info_request_msg->show_flags, uid,
-				       NO_VAL, msg->protocol_version);
+				       NO_VAL, &job_info_request_msg->filter,
+				       msg->protocol_version);
 		} else {
 			pack_all_jobs(&dump, &dump_size,
 				      job_info_request_msg->show_flags, uid,
-				      NO_VAL, msg->protocol_version);
+				      NO_VAL, &job_info_request_msg->filter,
+				      msg->protocol_version);
 		}
 		unlock_slurmctld(job_read_lock);
 		END_TIMER2("_slurm_rpc_dump_jobs");
@@ -1710,7 +1730,8 @@ static void _slurm_rpc_dump_jobs_user(slurm_msg_t * msg)
 	debug3("Processing RPC: REQUEST_JOB_USER_INFO from uid=%d", uid);
 	lock_slurmctld(job_read_lock);
 	pack_all_jobs(&dump, &dump_size, job_info_request_msg->show_flags, uid,
-		      job_info_request_msg->user_id, msg->protocol_version);
+		      job_info_request_msg->user_id, NULL,
+		      msg->protocol_version);
 	unlock_slurmctld(job_read_lock);
 	END_TIMER2("_slurm_rpc_dump_job_user");
 #if 0
@@ -1958,6 +1979,7 @@ static void _slurm_rpc_dump_nodes(slurm_msg_t * msg)
 	slurm_msg_t response_msg;
 	node_info_request_msg_t *node_req_msg =
 		(node_info_request_msg_t *) msg->data;
+	node_snapshot_ref_t *snap_ref;
 	/* Locks: Read config, write node (reset allocated CPU count in some
 	 * select plugins), read part (for part_is_visible) */
 	slurmctld_lock_t node_write_lock = {
@@ -1985,9 +2007,16 @@ static void _slurm_rpc_dump_nodes(slurm_msg_t * msg)
 		debug3("_slurm_rpc_dump_nodes, no change");
 		slurm_send_rc_msg(msg, SLURM_NO_CHANGE_IN_DATA);
 	} else {
-		pack_all_node(&dump, &dump_size, node_req_msg->show_flags,
-			      uid, msg->protocol_version);
+		snap_ref = get_node_snapshot(node_req_msg->show_flags, uid,
+					     msg->protocol_version);
+		if (!snap_ref) {
+			pack_all_node(&dump, &dump_size,
+				      node_req_msg->show_flags, uid,
+				      msg->protocol_version);
+		}
 		unlock_slurmctld(node_write_lock);
+		if (snap_ref)
+			pack_node_snapshot(snap_ref, &dump, &dump_size);
 		END_TIMER2("_slurm_rpc_dump_nodes");
 #if 0
 		info("_slurm_rpc_dump_nodes, size=%d %s", dump_size, TIME_STR);
@@ -2983,6 +3012,92 @@ static void _slurm_rpc_event_log(slurm_msg_t * msg)
 	slurm_send_rc_msg(msg, error_code);
 }
 
+/* Apply one node registration, job and node write locks must be set */
+static void _node_reg_apply(slurm_msg_t *msg, int *error_code, bool *newly_up)
+{
+	slurm_node_registration_status_msg_t *node_reg_stat_msg =
+		(slurm_node_registration_status_msg_t *) msg->data;
+
+#ifdef HAVE_FRONT_END		/* Operates only on front-end */
+	*error_code = validate_nodes_via_front_end(node_reg_stat_msg,
+						   msg->protocol_version,
+						   newly_up);
+#else
+	validate_jobs_on_node(node_reg_stat_msg);
+	*error_code = validate_node_specs(node_reg_stat_msg,
+					  msg->protocol_version, newly_up);
+#endif
+}
+
+/*
+ * Queue a node registration and wait for it to be applied. The first waiting
+ *	thread which finds no batch in progress applies up to
+ *	NODE_REG_BATCH_MAX queued registrations under a single slurmctld lock,
+ *	so a registration storm after a restart does not take the job and node
+ *	write locks once per node.
+ */
+static void _node_reg_batch(slurm_msg_t *msg, int *error_code, bool *newly_up)
+{
+	/* Locks: Read config, write job, write node */
+	slurmctld_lock_t job_write_lock = {
+		READ_LOCK, WRITE_LOCK, WRITE_LOCK, NO_LOCK, NO_LOCK };
+	node_reg_req_t req, *batch, *req_ptr;
+	int batch_cnt;
+
+	memset(&req, 0, sizeof(req));
+	req.msg = msg;
+
+	slurm_mutex_lock(&node_reg_mutex);
+	if (node_reg_tail)
+		node_reg_tail->next = &req;
+	else
+		node_reg_head = &req;
+	node_reg_tail = &req;
+
+	while (!req.done) {
+		if (node_reg_busy) {
+			slurm_cond_wait(&node_reg_cond, &node_reg_mutex);
+			continue;
+		}
+
+		/* Take the head of the queue, which includes our request */
+		node_reg_busy = true;
+		batch = node_reg_head;
+		for (batch_cnt = 1, req_ptr = batch;
+		     req_ptr->next && (batch_cnt < NODE_REG_BATCH_MAX);
+		     batch_cnt++)
+			req_ptr = req_ptr->next;
+		node_reg_head = req_ptr->next;
+		if (!node_reg_head)
+			node_reg_tail = NULL;
+		req_ptr->next = NULL;
+		slurm_mutex_unlock(&node_reg_mutex);
+
+		lock_slurmctld(job_write_lock);
+		for (req_ptr = batch; req_ptr; req_ptr = req_ptr->next) {
+			_node_reg_apply(req_ptr->msg, &req_ptr->error_code,
+					&req_ptr->newly_up);
+		}
+		unlock_slurmctld(job_write_lock);
+		if (batch_cnt > 1)
+			debug2("%s: applied %d node registrations",
+			       __func__, batch_cnt);
+
+		slurm_mutex_lock(&node_reg_mutex);
+		while (batch) {
+			req_ptr = batch->next;
+			batch->done = true;
+			batch = req_ptr;
+		}
+		node_reg_busy = false;
+		slurm_cond_broadcast(&node_reg_cond);
+	}
+	slurm_mutex_unlock(&node_reg_mutex);
+
+	*error_code = req.error_code;
+	*newly_up = req.newly_up;
+}
+
 /* _slurm_rpc_node_registration - process RPC to determine if a node's
  *	actual configuration satisfies the configured specification */
 static void _slurm_rpc_node_registration(slurm_msg_t * msg,
@@ -2994,9 +3109,6 @@ static void _slurm_rpc_node_registration(slurm_msg_t * msg,
 	bool newly_up = false;
 	slurm_node_registration_status_msg_t *node_reg_stat_msg =
 		(slurm_node_registration_status_msg_t *) msg->data;
-	/* Locks: Read config, write job, write node */
-	slurmctld_lock_t job_write_lock = {
-		READ_LOCK, WRITE_LOCK, WRITE_LOCK, NO_LOCK, NO_LOCK };
 	uid_t uid = g_slurm_auth_get_uid(msg->auth_cred,
 					 slurmctld_config.auth_info);
 
@@ -3026,20 +3138,13 @@ static void _slurm_rpc_node_registration(slurm_msg_t * msg,
 			      "set DebugFlags=NO_CONF_HASH in your slurm.conf.",
 			      node_reg_stat_msg->node_name);
 		}
-		if (!running_composite)
-			lock_slurmctld(job_write_lock);
-#ifdef HAVE_FRONT_END		/* Operates only on front-end */
-		error_code = validate_nodes_via_front_end(node_reg_stat_msg,
-							  msg->protocol_version,
-							  &newly_up);
-#else
-		validate_jobs_on_node(node_reg_stat_msg);
-		error_code = validate_node_specs(node_reg_stat_msg,
-						 msg->protocol_version,
-						 &newly_up);
-#endif
-		if (!running_composite)
-			unlock_slurmctld(job_write_lock);
+		/* Registrations aggregated in a composite message (msg_aggr)
+		 * already run under the job write lock taken by
+		 * _slurm_rpc_comp_msg_list(), so they can not be batched */
+		if (running_composite)
+			_node_reg_apply(msg, &error_code, &newly_up);
+		else
+			_node_reg_batch(msg, &error_code, &newly_up);
 		END_TIMER2("_slurm_rpc_node_registration");
 		if (newly_up) {
 			queue_job_scheduler();
@@ -6527,8 +6632,16 @@ static void  _slurm_rpc_comp_msg_list(composite_msg_t * comp_msg,
 
 	START_TIMER;
 
+	slurmctld_diag_stats.aggr_comp_cnt++;
+	slurmctld_diag_stats.aggr_window_sum += comp_msg->window_time;
+	slurmctld_diag_stats.aggr_window_max =
+		MAX(slurmctld_diag_stats.aggr_window_max,
+		    comp_msg->window_time);
+
 	itr = list_iterator_create(comp_msg->msg_list);
 	while ((next_msg = list_next(itr))) {
+		if (next_msg->msg_type != MESSAGE_COMPOSITE)
+			slurmctld_diag_stats.aggr_msg_cnt++;
 		if (slurm_delta_tv(start_tv) >= timeout) {
 			END_TIMER;
 			if (slurmctld_conf.debug_flags & DEBUG_FLAG_ROUTE)
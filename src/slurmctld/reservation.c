@@ -118,6 +118,35 @@ typedef struct constraint_slot {
 	time_t end;
 	uint32_t value;
 } constraint_slot_t;
+
+/*
+ * Time index of resv_list, used by job_test_resv() and find_resv_end() in
+ * place of a scan of every reservation for each job and start time tested.
+ * Records are referenced by pointer, so the index is rebuilt whenever
+ * last_resv_update or the reservation count changes.
+ */
+#define RESV_INDEX_BLOCK	16
+
+typedef struct resv_index_rec {
+	time_t end_time;
+	uint32_t list_inx;		/* position in resv_list */
+	slurmctld_resv_t *resv_ptr;
+	time_t start_time;		/* start_time_first of reservation */
+} resv_index_rec_t;
+
+static pthread_mutex_t resv_index_lock = PTHREAD_MUTEX_INITIALIZER;
+static resv_index_rec_t *resv_index = NULL;	/* sorted by start_time,
+						 * excludes TIME_FLOAT */
+static uint32_t resv_index_cnt = 0;
+static time_t *resv_index_block_end = NULL;	/* latest end_time of each
+						 * RESV_INDEX_BLOCK records */
+static resv_index_rec_t *resv_index_float = NULL; /* TIME_FLOAT records */
+static uint32_t resv_index_float_cnt = 0;
+static time_t *resv_index_end = NULL;	/* end_time of every reservation,
+					 * sorted */
+static time_t resv_index_expire = 0;	/* rebuild after this end_time */
+static int resv_index_list_cnt = -1;
+static time_t resv_index_time = 0;	/* when the index was built */
 /*
  * the associated functions are the following
  */
@@ -173,6 +202,11 @@ static int  _post_resv_update(slurmctld_resv_t *resv_ptr,
 static int  _resize_resv(slurmctld_resv_t *resv_ptr, uint32_t node_cnt);
 static void _restore_resv(slurmctld_resv_t *dest_resv,
 			  slurmctld_resv_t *src_resv);
+static void _resv_index_build(bool advanced);
+static uint32_t _resv_index_find(time_t start_time, time_t end_time,
+				 resv_index_rec_t **recs);
+static void _resv_index_free(void);
+static void _resv_index_validate(bool advance);
 static bool _resv_overlap(time_t start_time, time_t end_time,
 			  uint32_t flags, bitstr_t *node_bitmap,
 			  slurmctld_resv_t *this_resv_ptr);
@@ -2477,6 +2511,9 @@ extern int create_resv(resv_desc_msg_t *resv_desc_ptr)
 /* Purge all reservation data structures */
 extern void resv_fini(void)
 {
+	slurm_mutex_lock(&resv_index_lock);
+	_resv_index_free();
+	slurm_mutex_unlock(&resv_index_lock);
 	FREE_NULL_LIST(resv_list);
 }
 
@@ -4935,6 +4972,188 @@ extern uint32_t job_test_watts_resv(struct job_record *job_ptr, time_t when,
 	return resv_cnt;
 }
 
+static int _resv_index_end_cmp(const void *x, const void *y)
+{
+	time_t t1 = *(time_t *) x;
+	time_t t2 = *(time_t *) y;
+
+	if (t1 < t2)
+		return -1;
+	if (t1 > t2)
+		return 1;
+	return 0;
+}
+
+static int _resv_index_inx_cmp(const void *x, const void *y)
+{
+	resv_index_rec_t *rec1 = (resv_index_rec_t *) x;
+	resv_index_rec_t *rec2 = (resv_index_rec_t *) y;
+
+	if (rec1->list_inx < rec2->list_inx)
+		return -1;
+	if (rec1->list_inx > rec2->list_inx)
+		return 1;
+	return 0;
+}
+
+static int _resv_index_start_cmp(const void *x, const void *y)
+{
+	resv_index_rec_t *rec1 = (resv_index_rec_t *) x;
+	resv_index_rec_t *rec2 = (resv_index_rec_t *) y;
+
+	if (rec1->start_time < rec2->start_time)
+		return -1;
+	if (rec1->start_time > rec2->start_time)
+		return 1;
+	return _resv_index_inx_cmp(x, y);
+}
+
+static void _resv_index_free(void)
+{
+	xfree(resv_index);
+	xfree(resv_index_block_end);
+	xfree(resv_index_float);
+	xfree(resv_index_end);
+	resv_index_cnt = 0;
+	resv_index_float_cnt = 0;
+	resv_index_expire = 0;
+	resv_index_list_cnt = -1;
+	resv_index_time = 0;
+}
+
+/*
+ * Build the reservation time index from resv_list.
+ * IN advanced - set if expired recurring reservations were just advanced,
+ *		 so the index next expires at the first end_time in the
+ *		 future rather than at the first end_time of any reservation
+ */
+static void _resv_index_build(bool advanced)
+{
+	ListIterator iter;
+	slurmctld_resv_t *resv_ptr;
+	resv_index_rec_t *rec;
+	time_t now = time(NULL);
+	uint32_t b, i, inx = 0;
+	int list_cnt = 0;
+
+	_resv_index_free();
+	if (resv_list)
+		list_cnt = list_count(resv_list);
+	resv_index_list_cnt = list_cnt;
+	resv_index_time = now;
+	if (list_cnt == 0)
+		return;
+
+	resv_index = xmalloc(sizeof(resv_index_rec_t) * list_cnt);
+	resv_index_float = xmalloc(sizeof(resv_index_rec_t) * list_cnt);
+	resv_index_end = xmalloc(sizeof(time_t) * list_cnt);
+	iter = list_iterator_create(resv_list);
+	while ((resv_ptr = (slurmctld_resv_t *) list_next(iter))) {
+		resv_index_end[inx] = resv_ptr->end_time;
+		if (resv_ptr->flags & RESERVE_FLAG_TIME_FLOAT) {
+			rec = &resv_index_float[resv_index_float_cnt++];
+		} else {
+			rec = &resv_index[resv_index_cnt++];
+			if ((!advanced || (resv_ptr->end_time > now)) &&
+			    ((resv_index_expire == 0) ||
+			     (resv_index_expire > resv_ptr->end_time)))
+				resv_index_expire = resv_ptr->end_time;
+		}
+		rec->end_time = resv_ptr->end_time;
+		rec->list_inx = inx++;
+		rec->resv_ptr = resv_ptr;
+		rec->start_time = resv_ptr->start_time_first;
+	}
+	list_iterator_destroy(iter);
+
+	qsort(resv_index, resv_index_cnt, sizeof(resv_index_rec_t),
+	      _resv_index_start_cmp);
+	qsort(resv_index_end, inx, sizeof(time_t), _resv_index_end_cmp);
+	b = (resv_index_cnt + RESV_INDEX_BLOCK - 1) / RESV_INDEX_BLOCK;
+	resv_index_block_end = xmalloc(sizeof(time_t) * (b + 1));
+	for (i = 0; i < resv_index_cnt; i++) {
+		b = i / RESV_INDEX_BLOCK;
+		if (resv_index_block_end[b] < resv_index[i].end_time)
+			resv_index_block_end[b] = resv_index[i].end_time;
+	}
+}
+
+/*
+ * Rebuild the reservation time index if resv_list changed since it was
+ * built. If advance is set and some reservation ended since, first advance
+ * expired recurring reservations as a scan of resv_list would.
+ * resv_index_lock must be locked.
+ */
+static void _resv_index_validate(bool advance)
+{
+	ListIterator iter;
+	slurmctld_resv_t *resv_ptr;
+	time_t now = time(NULL);
+	int list_cnt = 0;
+
+	if (resv_list)
+		list_cnt = list_count(resv_list);
+	if (advance && resv_list && resv_index_expire &&
+	    (now >= resv_index_expire)) {
+		iter = list_iterator_create(resv_list);
+		while ((resv_ptr = (slurmctld_resv_t *) list_next(iter))) {
+			if (!(resv_ptr->flags & RESERVE_FLAG_TIME_FLOAT) &&
+			    (resv_ptr->end_time <= now))
+				_advance_resv_time(resv_ptr);
+		}
+		list_iterator_destroy(iter);
+		_resv_index_build(true);
+		return;
+	}
+	if ((resv_index_time == 0) || (last_resv_update >= resv_index_time) ||
+	    (resv_index_list_cnt != list_cnt))
+		_resv_index_build(false);
+}
+
+/*
+ * Find the reservations which may overlap a time window. TIME_FLOAT
+ * reservations are always included since their times are relative.
+ * IN start_time, end_time - time window
+ * OUT recs - matching index records in resv_list order, caller must xfree
+ * RET count of records
+ */
+static uint32_t _resv_index_find(time_t start_time, time_t end_time,
+				 resv_index_rec_t **recs)
+{
+	uint32_t b, cnt = 0, i, last, lo, hi, mid;
+
+	slurm_mutex_lock(&resv_index_lock);
+	_resv_index_validate(true);
+	*recs = xmalloc(sizeof(resv_index_rec_t) *
+			(resv_index_cnt + resv_index_float_cnt + 1));
+
+	/* Records starting before end_time, then skip blocks ended already */
+	lo = 0;
+	hi = resv_index_cnt;
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (resv_index[mid].start_time < end_time)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	for (b = 0; (b * RESV_INDEX_BLOCK) < lo; b++) {
+		if (resv_index_block_end[b] <= start_time)
+			continue;
+		last = MIN((b + 1) * RESV_INDEX_BLOCK, lo);
+		for (i = b * RESV_INDEX_BLOCK; i < last; i++) {
+			if (resv_index[i].end_time > start_time)
+				(*recs)[cnt++] = resv_index[i];
+		}
+	}
+	for (i = 0; i < resv_index_float_cnt; i++)
+		(*recs)[cnt++] = resv_index_float[i];
+	slurm_mutex_unlock(&resv_index_lock);
+
+	qsort(*recs, cnt, sizeof(resv_index_rec_t), _resv_index_inx_cmp);
+	return cnt;
+}
+
 /*
  * Determine which nodes a job can use based upon reservations
  * IN job_ptr      - job to test
@@ -4966,6 +5185,8 @@ extern int job_test_resv(struct job_record *job_ptr, time_t *when,
 	time_t start_relative, end_relative;
 	time_t now = time(NULL);
 	ListIterator iter;
+	resv_index_rec_t *resv_recs;
+	uint32_t j, resv_cnt;
 	int i, rc = SLURM_SUCCESS, rc2;
 
 	*resv_overlap = false;	/* initialize to false */
@@ -5089,8 +5310,10 @@ extern int job_test_resv(struct job_record *job_ptr, time_t *when,
 	for (i = 0; ; i++) {
 		lic_resv_time = (time_t) 0;
 
-		iter = list_iterator_create(resv_list);
-		while ((resv_ptr = (slurmctld_resv_t *) list_next(iter))) {
+		resv_cnt = _resv_index_find(job_start_time, job_end_time,
+					    &resv_recs);
+		for (j = 0; j < resv_cnt; j++) {
+			resv_ptr = resv_recs[j].resv_ptr;
 			if (resv_ptr->flags & RESERVE_FLAG_TIME_FLOAT) {
 				start_relative = resv_ptr->start_time + now;
 				if (resv_ptr->duration == INFINITE)
@@ -5174,7 +5397,7 @@ extern int job_test_resv(struct job_record *job_ptr, time_t *when,
 				}
 			}
 		}
-		list_iterator_destroy(iter);
+		xfree(resv_recs);
 
 		if ((rc == SLURM_SUCCESS) && move_time) {
 			if (license_job_test(job_ptr, job_start_time, reboot)
@@ -5212,21 +5435,28 @@ extern int job_test_resv(struct job_record *job_ptr, time_t *when,
  */
 extern time_t find_resv_end(time_t start_time)
 {
-	ListIterator iter;
-	slurmctld_resv_t *resv_ptr;
 	time_t end_time = 0;
+	uint32_t cnt, lo, hi, mid;
 
 	if (!resv_list)
 		return end_time;
 
-	iter = list_iterator_create(resv_list);
-	while ((resv_ptr = (slurmctld_resv_t *) list_next(iter))) {
-		if (start_time > resv_ptr->end_time)
-			continue;
-		if ((end_time == 0) || (resv_ptr->end_time < end_time))
-			end_time = resv_ptr->end_time;
+	slurm_mutex_lock(&resv_index_lock);
+	_resv_index_validate(false);
+	cnt = (resv_index_list_cnt > 0) ? resv_index_list_cnt : 0;
+	lo = 0;
+	hi = cnt;
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (resv_index_end[mid] < start_time)
+			lo = mid + 1;
+		else
+			hi = mid;
 	}
-	list_iterator_destroy(iter);
+	if (lo < cnt)
+		end_time = resv_index_end[lo];
+	slurm_mutex_unlock(&resv_index_lock);
+
 	return end_time;
 }
 
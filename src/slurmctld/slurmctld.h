@@ -183,6 +183,11 @@ typedef struct diag_stats {
 	uint32_t bf_queue_len_sum;
 	time_t   bf_when_last_cycle;
 	uint32_t bf_active;
+
+	uint32_t aggr_comp_cnt;
+	uint32_t aggr_msg_cnt;
+	uint64_t aggr_window_sum;
+	uint32_t aggr_window_max;
 } diag_stats_t;
 
 /* This is used to point out constants that exist in the
@@ -454,6 +459,22 @@ typedef struct job_feature {
 #define WHOLE_NODE_USER		0x02
 #define WHOLE_NODE_MCS		0x03
 
+/* Job details which rarely change after submission. Job array task records
+ * split from the same job array share these strings rather than copies of
+ * them, see job_array_split(). A record takes private copies of all of them
+ * before modifying any, see _unshare_job_details() */
+typedef struct job_details_shared {
+	uint32_t ref_cnt;		/* count of job_details using this */
+	uint32_t argc;			/* count of argv elements */
+	char **argv;			/* arguments for a batch job script */
+	char *ckpt_dir;			/* directory to store checkpoint
+					 * images */
+	char *std_err;			/* pathname of job's stderr file */
+	char *std_in;			/* pathname of job's stdin file */
+	char *std_out;			/* pathname of job's stdout file */
+	char *work_dir;			/* pathname of working directory */
+} job_details_shared_t;
+
 /* job_details - specification of a job's constraints,
  * can be purged after initiation */
 struct job_details {
@@ -483,6 +504,8 @@ struct job_details {
 	uint16_t cpus_per_task;		/* number of processors required for
 					 * each task */
 	List depend_list;		/* list of job_ptr:state pairs */
+	uint16_t depend_rc;		/* cached test_job_dependency() result,
+					 * 0 if it must be tested again */
 	char *dependency;		/* wait for other jobs */
 	char *orig_dependency;		/* original value (for archiving) */
 	uint16_t env_cnt;		/* size of env_sup (see below) */
@@ -539,6 +562,9 @@ struct job_details {
 	uint8_t whole_node;		/* WHOLE_NODE_REQUIRED: 1: --exclusive
 					 * WHOLE_NODE_USER: 2: --exclusive=user
 					 * WHOLE_NODE_MCS:  3: --exclusive=mcs */
+	job_details_shared_t *shared;	/* if set, argv, ckpt_dir, std_*
+					 * and work_dir are shared with other
+					 * job array task records */
 	char *work_dir;			/* pathname of working directory */
 	uint16_t x11;			/* --x11 flags */
 	char *x11_magic_cookie;		/* x11 magic cookie */
@@ -1805,6 +1831,7 @@ extern int num_pending_job_array_tasks(uint32_t array_job_id);
  * IN show_flags - job filtering options
  * IN uid - uid of user making request (for partition filtering)
  * IN filter_uid - pack only jobs belonging to this user if not NO_VAL
+ * IN filter - pack only jobs matching this filter if not NULL
  * IN protocol_version - slurm protocol version of client
  * global: job_list - global list of job records
  * NOTE: the buffer at *buffer_ptr must be xfreed by the caller
@@ -1813,6 +1840,7 @@ extern int num_pending_job_array_tasks(uint32_t array_job_id);
  */
 extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
 			  uint16_t show_flags, uid_t uid, uint32_t filter_uid,
+			  job_info_filter_t *filter,
 			  uint16_t protocol_version);
 
 /*
@@ -1824,6 +1852,7 @@ extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
  * IN job_ids - list of job_ids to pack
  * IN uid - uid of user making request (for partition filtering)
  * IN filter_uid - pack only jobs belonging to this user if not NO_VAL
+ * IN filter - pack only jobs matching this filter if not NULL
  * global: job_list - global list of job records
  * NOTE: the buffer at *buffer_ptr must be xfreed by the caller
  * NOTE: change _unpack_job_desc_msg() in common/slurm_protocol_pack.c
@@ -1831,6 +1860,7 @@ extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
  */
 extern void pack_spec_jobs(char **buffer_ptr, int *buffer_size, List job_ids,
 			   uint16_t show_flags, uid_t uid, uint32_t filter_uid,
+			   job_info_filter_t *filter,
 			   uint16_t protocol_version);
 
 /*
@@ -1850,6 +1880,34 @@ extern void pack_all_node (char **buffer_ptr, int *buffer_size,
 			   uint16_t show_flags, uid_t uid,
 			   uint16_t protocol_version);
 
+/* Reference to node records packed by get_node_snapshot() */
+typedef struct node_snapshot_ref node_snapshot_ref_t;
+
+/*
+ * get_node_snapshot - reference packed node records for a pack_all_node()
+ *	style reply, repacking them only when the node table has changed
+ * IN show_flags - node filtering options
+ * IN uid - uid of user making request (for partition filtering)
+ * IN protocol_version - slurm protocol version of client
+ * RET reference to pass to pack_node_snapshot() or NULL if protocol_version
+ *	is not current, in which case pack_all_node() must be used
+ * NOTE: READ lock_slurmctld config, node and partition before entry
+ */
+extern node_snapshot_ref_t *get_node_snapshot(uint16_t show_flags, uid_t uid,
+					      uint16_t protocol_version);
+
+/*
+ * pack_node_snapshot - build a pack_all_node() style reply from a node
+ *	snapshot reference and release the reference
+ * IN snap_ref - reference from get_node_snapshot()
+ * OUT buffer_ptr - pointer to the stored data
+ * OUT buffer_size - set to size of the buffer in bytes
+ * NOTE: the caller must xfree the buffer at *buffer_ptr
+ * NOTE: no locks are needed, call after releasing the slurmctld locks
+ */
+extern void pack_node_snapshot(node_snapshot_ref_t *snap_ref,
+			       char **buffer_ptr, int *buffer_size);
+
 /* Pack all scheduling statistics */
 extern void pack_all_stat(int resp, char **buffer_ptr, int *buffer_size,
 			  uint16_t protocol_version);
@@ -111,6 +111,17 @@ extern void pack_all_stat(int resp, char **buffer_ptr, int *buffer_size,
 			pack32(slurmctld_diag_stats.bf_depth_try_sum, buffer);
 			pack32(slurmctld_diag_stats.bf_queue_len_sum, buffer);
 			pack32(slurmctld_diag_stats.bf_active,	 buffer);
+
+			if (protocol_version >= SLURM_17_11_PROTOCOL_VERSION) {
+				pack32(slurmctld_diag_stats.aggr_comp_cnt,
+				       buffer);
+				pack32(slurmctld_diag_stats.aggr_msg_cnt,
+				       buffer);
+				pack64(slurmctld_diag_stats.aggr_window_sum,
+				       buffer);
+				pack32(slurmctld_diag_stats.aggr_window_max,
+				       buffer);
+			}
 		}
 	}
 
@@ -151,5 +162,10 @@ extern void reset_stats(int level)
 	slurmctld_diag_stats.bf_last_depth_try = 0;
 	slurmctld_diag_stats.bf_active = 0;
 
+	slurmctld_diag_stats.aggr_comp_cnt = 0;
+	slurmctld_diag_stats.aggr_msg_cnt = 0;
+	slurmctld_diag_stats.aggr_window_sum = 0;
+	slurmctld_diag_stats.aggr_window_max = 0;
+
 	last_proc_req_start = time(NULL);
 }
@@ -271,6 +271,21 @@ static pthread_cond_t  file_bcast_cond  = PTHREAD_COND_INITIALIZER;
 static int fb_read_lock = 0, fb_write_wait_lock = 0, fb_write_lock = 0;
 static List file_bcast_list = NULL;
 
+/*
+ * Pool of idle slurmstepd processes, already exec'd and waiting on their
+ * stdin pipe for _send_slurmstepd_init(). Sized by
+ * LaunchParameters=slurmstepd_pool=#.
+ */
+typedef struct {
+	int to_stepd;		/* write end of the slurmstepd's stdin */
+	int to_slurmd;		/* read end of the slurmstepd's stdout */
+} stepd_pool_ent_t;
+
+static pthread_mutex_t stepd_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static List stepd_pool_list = NULL;
+static int  stepd_pool_size = 0;
+static bool stepd_pool_filling = false;
+
 void
 slurmd_req(slurm_msg_t *msg)
 {
@@ -664,20 +679,174 @@ rwfail:
 
 
 /*
- * Fork and exec the slurmstepd, then send the slurmstepd its
- * initialization data.  Then wait for slurmstepd to send an "ok"
- * message before returning.  When the "ok" message is received,
- * the slurmstepd has created and begun listening on its unix
- * domain socket.
- *
- * Note that this code forks twice and it is the grandchild that
- * becomes the slurmstepd process, so the slurmstepd's parent process
- * will be init, not slurmd.
+ * Exec the slurmstepd in a new session. Called in a child of slurmd,
+ * which forks again so that the grandchild becomes the slurmstepd and its
+ * parent process will be init, not slurmd. The child exits right after
+ * that fork, so the caller must reap it. Never returns.
+ */
+static void
+_exec_slurmstepd(int *to_stepd, int *to_slurmd, uint16_t type, void *req)
+{
+	pid_t pid;
+#if (SLURMSTEPD_MEMCHECK == 1)
+	/* memcheck test of slurmstepd, option #1 */
+	char *const argv[3] = {"memcheck",
+			       (char *)conf->stepd_loc, NULL};
+#elif (SLURMSTEPD_MEMCHECK == 2)
+	/* valgrind test of slurmstepd, option #2 */
+	uint32_t job_id = 0, step_id = 0;
+	char log_file[256];
+	char *const argv[13] = {"valgrind", "--tool=memcheck",
+				"--error-limit=no",
+				"--leak-check=summary",
+				"--show-reachable=yes",
+				"--max-stackframe=16777216",
+				"--num-callers=20",
+				"--child-silent-after-fork=yes",
+				"--track-origins=yes",
+				log_file, (char *)conf->stepd_loc,
+				NULL};
+	if (type == LAUNCH_BATCH_JOB) {
+		job_id = ((batch_job_launch_msg_t *)req)->job_id;
+		step_id = ((batch_job_launch_msg_t *)req)->step_id;
+	} else if (type == LAUNCH_TASKS) {
+		job_id = ((launch_tasks_request_msg_t *)req)->job_id;
+		step_id = ((launch_tasks_request_msg_t *)req)->job_step_id;
+	}
+	snprintf(log_file, sizeof(log_file),
+		 "--log-file=/tmp/slurmstepd_valgrind_%u.%u",
+		 job_id, step_id);
+#elif (SLURMSTEPD_MEMCHECK == 3)
+	/* valgrind/drd test of slurmstepd, option #3 */
+	uint32_t job_id = 0, step_id = 0;
+	char log_file[256];
+	char *const argv[10] = {"valgrind", "--tool=drd",
+				"--error-limit=no",
+				"--max-stackframe=16777216",
+				"--num-callers=20",
+				"--child-silent-after-fork=yes",
+				log_file, (char *)conf->stepd_loc,
+				NULL};
+	if (type == LAUNCH_BATCH_JOB) {
+		job_id = ((batch_job_launch_msg_t *)req)->job_id;
+		step_id = ((batch_job_launch_msg_t *)req)->step_id;
+	} else if (type == LAUNCH_TASKS) {
+		job_id = ((launch_tasks_request_msg_t *)req)->job_id;
+		step_id = ((launch_tasks_request_msg_t *)req)->job_step_id;
+	}
+	snprintf(log_file, sizeof(log_file),
+		 "--log-file=/tmp/slurmstepd_valgrind_%u.%u",
+		 job_id, step_id);
+#elif (SLURMSTEPD_MEMCHECK == 4)
+	/* valgrind/helgrind test of slurmstepd, option #4 */
+	uint32_t job_id = 0, step_id = 0;
+	char log_file[256];
+	char *const argv[10] = {"valgrind", "--tool=helgrind",
+				"--error-limit=no",
+				"--max-stackframe=16777216",
+				"--num-callers=20",
+				"--child-silent-after-fork=yes",
+				log_file, (char *)conf->stepd_loc,
+				NULL};
+	if (type == LAUNCH_BATCH_JOB) {
+		job_id = ((batch_job_launch_msg_t *)req)->job_id;
+		step_id = ((batch_job_launch_msg_t *)req)->step_id;
+	} else if (type == LAUNCH_TASKS) {
+		job_id = ((launch_tasks_request_msg_t *)req)->job_id;
+		step_id = ((launch_tasks_request_msg_t *)req)->job_step_id;
+	}
+	snprintf(log_file, sizeof(log_file),
+		 "--log-file=/tmp/slurmstepd_valgrind_%u.%u",
+		 job_id, step_id);
+#else
+	/* no memory checking, default */
+	char *const argv[2] = { (char *)conf->stepd_loc, NULL};
+#endif
+	int i;
+	int failed = 0;
+	/* inform slurmstepd about our config */
+	setenv("SLURM_CONF", conf->conffile, 1);
+
+	/*
+	 * Child forks and exits
+	 */
+	if (setsid() < 0) {
+		error("_forkexec_slurmstepd: setsid: %m");
+		failed = 1;
+	}
+	if ((pid = fork()) < 0) {
+		error("_forkexec_slurmstepd: "
+		      "Unable to fork grandchild: %m");
+		failed = 2;
+	} else if (pid > 0) { /* child */
+		exit(0);
+	}
+
+	/*
+	 * Just in case we (or someone we are linking to)
+	 * opened a file and didn't do a close on exec.  This
+	 * is needed mostly to protect us against libs we link
+	 * to that don't set the flag as we should already be
+	 * setting it for those that we open.  The number 256
+	 * is an arbitrary number based off test7.9.
+	 */
+	for (i=3; i<256; i++) {
+		(void) fcntl(i, F_SETFD, FD_CLOEXEC);
+	}
+
+	/*
+	 * Grandchild exec's the slurmstepd
+	 *
+	 * If the slurmd is being shutdown/restarted before
+	 * the pipe happens the old conf->lfd could be reused
+	 * and if we close it the dup2 below will fail.
+	 */
+	if ((to_stepd[0] != conf->lfd)
+	    && (to_slurmd[1] != conf->lfd))
+		slurm_shutdown_msg_engine(conf->lfd);
+
+	if (close(to_stepd[1]) < 0)
+		error("close write to_stepd in grandchild: %m");
+	if (close(to_slurmd[0]) < 0)
+		error("close read to_slurmd in parent: %m");
+
+	(void) close(STDIN_FILENO); /* ignore return */
+	if (dup2(to_stepd[0], STDIN_FILENO) == -1) {
+		error("dup2 over STDIN_FILENO: %m");
+		exit(1);
+	}
+	fd_set_close_on_exec(to_stepd[0]);
+	(void) close(STDOUT_FILENO); /* ignore return */
+	if (dup2(to_slurmd[1], STDOUT_FILENO) == -1) {
+		error("dup2 over STDOUT_FILENO: %m");
+		exit(1);
+	}
+	fd_set_close_on_exec(to_slurmd[1]);
+	(void) close(STDERR_FILENO); /* ignore return */
+	if (dup2(devnull, STDERR_FILENO) == -1) {
+		error("dup2 /dev/null to STDERR_FILENO: %m");
+		exit(1);
+	}
+	fd_set_noclose_on_exec(STDERR_FILENO);
+	log_fini();
+	if (!failed) {
+		if (conf->chos_loc && !access(conf->chos_loc, X_OK))
+			execvp(conf->chos_loc, argv);
+		else
+			execvp(argv[0], argv);
+		error("exec of slurmstepd failed: %m");
+	}
+	exit(2);
+}
+
+/*
+ * Fork and exec a slurmstepd, returning the slurmd ends of its stdin and
+ * stdout pipes. The slurmstepd blocks reading its initialization data
+ * until it is sent by _send_slurmstepd_init().
  */
 static int
-_forkexec_slurmstepd(uint16_t type, void *req,
-		     slurm_addr_t *cli, slurm_addr_t *self,
-		     const hostset_t step_hset, uint16_t protocol_version)
+_spawn_slurmstepd(uint16_t type, void *req, int *to_stepd_fd,
+		  int *to_slurmd_fd)
 {
 	pid_t pid;
 	int to_stepd[2] = {-1, -1};
@@ -685,11 +854,10 @@ _forkexec_slurmstepd(uint16_t type, void *req,
 
 	if (pipe(to_stepd) < 0 || pipe(to_slurmd) < 0) {
 		error("_forkexec_slurmstepd pipe failed: %m");
-		return SLURM_FAILURE;
-	}
-
-	if (_add_starting_step(type, req)) {
-		error("_forkexec_slurmstepd failed in _add_starting_step: %m");
+		if (to_stepd[0] >= 0) {
+			close(to_stepd[0]);
+			close(to_stepd[1]);
+		}
 		return SLURM_FAILURE;
 	}
 
@@ -699,228 +867,276 @@ _forkexec_slurmstepd(uint16_t type, void *req,
 		close(to_stepd[1]);
 		close(to_slurmd[0]);
 		close(to_slurmd[1]);
-		_remove_starting_step(type, req);
 		return SLURM_FAILURE;
-	} else if (pid > 0) {
-		int rc = SLURM_SUCCESS;
+	} else if (pid == 0) {
+		_exec_slurmstepd(to_stepd, to_slurmd, type, req);
+	}
+
+	if (close(to_stepd[0]) < 0)
+		error("Unable to close read to_stepd in parent: %m");
+	if (close(to_slurmd[1]) < 0)
+		error("Unable to close write to_slurmd in parent: %m");
+
+	/* Reap child */
+	if (waitpid(pid, NULL, 0) < 0)
+		error("Unable to reap slurmd child process");
+
+	*to_stepd_fd = to_stepd[1];
+	*to_slurmd_fd = to_slurmd[0];
+	return SLURM_SUCCESS;
+}
+
+/*
+ * Send initialization data to the slurmstepd over the to_stepd pipe, and
+ * wait for the return code reply on the to_slurmd pipe.
+ * RET return code from the slurmstepd, or -1 if the initialization data
+ *     could not be sent at all (e.g. a pooled slurmstepd went away).
+ */
+static int
+_init_slurmstepd(int to_stepd, int to_slurmd, uint16_t type, void *req,
+		 slurm_addr_t *cli, slurm_addr_t *self,
+		 const hostset_t step_hset, uint16_t protocol_version)
+{
+	int rc = SLURM_SUCCESS;
 #if (SLURMSTEPD_MEMCHECK == 0)
-		int i;
-		time_t start_time = time(NULL);
+	int i;
+	time_t start_time = time(NULL);
 #endif
-		/*
-		 * Parent sends initialization data to the slurmstepd
-		 * over the to_stepd pipe, and waits for the return code
-		 * reply on the to_slurmd pipe.
-		 */
-		if (close(to_stepd[0]) < 0)
-			error("Unable to close read to_stepd in parent: %m");
-		if (close(to_slurmd[1]) < 0)
-			error("Unable to close write to_slurmd in parent: %m");
-
-		if ((rc = _send_slurmstepd_init(to_stepd[1], type,
-						req, cli, self,
-						step_hset,
-						protocol_version)) != 0) {
-			error("Unable to init slurmstepd");
-			goto done;
-		}
 
-		/* If running under valgrind/memcheck, this pipe doesn't work
-		 * correctly so just skip it. */
+	if (_send_slurmstepd_init(to_stepd, type, req, cli, self, step_hset,
+				  protocol_version) != 0) {
+		error("Unable to init slurmstepd");
+		return -1;
+	}
+
+	/* If running under valgrind/memcheck, this pipe doesn't work
+	 * correctly so just skip it. */
 #if (SLURMSTEPD_MEMCHECK == 0)
-		i = read(to_slurmd[0], &rc, sizeof(int));
-		if (i < 0) {
-			error("%s: Can not read return code from slurmstepd "
-			      "got %d: %m", __func__, i);
-			rc = SLURM_FAILURE;
-		} else if (i != sizeof(int)) {
-			error("%s: slurmstepd failed to send return code "
-			      "got %d: %m", __func__, i);
-			rc = SLURM_FAILURE;
-		} else {
-			int delta_time = time(NULL) - start_time;
-			int cc;
-			if (delta_time > 5) {
-				info("Warning: slurmstepd startup took %d sec, "
-				     "possible file system problem or full "
-				     "memory", delta_time);
-			}
-			if (rc != SLURM_SUCCESS)
-				error("slurmstepd return code %d", rc);
-
-			cc = SLURM_SUCCESS;
-			cc = write(to_stepd[1], &cc, sizeof(int));
-			if (cc != sizeof(int)) {
-				error("%s: failed to send ack to stepd %d: %m",
-				      __func__, cc);
-			}
-		}
-#endif
-	done:
-		if (_remove_starting_step(type, req))
-			error("Error cleaning up starting_step list");
-
-		/* Reap child */
-		if (waitpid(pid, NULL, 0) < 0)
-			error("Unable to reap slurmd child process");
-		if (close(to_stepd[1]) < 0)
-			error("close write to_stepd in parent: %m");
-		if (close(to_slurmd[0]) < 0)
-			error("close read to_slurmd in parent: %m");
-		return rc;
+	i = read(to_slurmd, &rc, sizeof(int));
+	if (i < 0) {
+		error("%s: Can not read return code from slurmstepd "
+		      "got %d: %m", __func__, i);
+		rc = SLURM_FAILURE;
+	} else if (i != sizeof(int)) {
+		error("%s: slurmstepd failed to send return code "
+		      "got %d: %m", __func__, i);
+		rc = SLURM_FAILURE;
 	} else {
-#if (SLURMSTEPD_MEMCHECK == 1)
-		/* memcheck test of slurmstepd, option #1 */
-		char *const argv[3] = {"memcheck",
-				       (char *)conf->stepd_loc, NULL};
-#elif (SLURMSTEPD_MEMCHECK == 2)
-		/* valgrind test of slurmstepd, option #2 */
-		uint32_t job_id = 0, step_id = 0;
-		char log_file[256];
-		char *const argv[13] = {"valgrind", "--tool=memcheck",
-					"--error-limit=no",
-					"--leak-check=summary",
-					"--show-reachable=yes",
-					"--max-stackframe=16777216",
-					"--num-callers=20",
-					"--child-silent-after-fork=yes",
-					"--track-origins=yes",
-					log_file, (char *)conf->stepd_loc,
-					NULL};
-		if (type == LAUNCH_BATCH_JOB) {
-			job_id = ((batch_job_launch_msg_t *)req)->job_id;
-			step_id = ((batch_job_launch_msg_t *)req)->step_id;
-		} else if (type == LAUNCH_TASKS) {
-			job_id = ((launch_tasks_request_msg_t *)req)->job_id;
-			step_id = ((launch_tasks_request_msg_t *)req)->job_step_id;
-		}
-		snprintf(log_file, sizeof(log_file),
-			 "--log-file=/tmp/slurmstepd_valgrind_%u.%u",
-			 job_id, step_id);
-#elif (SLURMSTEPD_MEMCHECK == 3)
-		/* valgrind/drd test of slurmstepd, option #3 */
-		uint32_t job_id = 0, step_id = 0;
-		char log_file[256];
-		char *const argv[10] = {"valgrind", "--tool=drd",
-					"--error-limit=no",
-					"--max-stackframe=16777216",
-					"--num-callers=20",
-					"--child-silent-after-fork=yes",
-					log_file, (char *)conf->stepd_loc,
-					NULL};
-		if (type == LAUNCH_BATCH_JOB) {
-			job_id = ((batch_job_launch_msg_t *)req)->job_id;
-			step_id = ((batch_job_launch_msg_t *)req)->step_id;
-		} else if (type == LAUNCH_TASKS) {
-			job_id = ((launch_tasks_request_msg_t *)req)->job_id;
-			step_id = ((launch_tasks_request_msg_t *)req)->job_step_id;
+		int delta_time = time(NULL) - start_time;
+		int cc;
+		if (delta_time > 5) {
+			info("Warning: slurmstepd startup took %d sec, "
+			     "possible file system problem or full "
+			     "memory", delta_time);
 		}
-		snprintf(log_file, sizeof(log_file),
-			 "--log-file=/tmp/slurmstepd_valgrind_%u.%u",
-			 job_id, step_id);
-#elif (SLURMSTEPD_MEMCHECK == 4)
-		/* valgrind/helgrind test of slurmstepd, option #4 */
-		uint32_t job_id = 0, step_id = 0;
-		char log_file[256];
-		char *const argv[10] = {"valgrind", "--tool=helgrind",
-					"--error-limit=no",
-					"--max-stackframe=16777216",
-					"--num-callers=20",
-					"--child-silent-after-fork=yes",
-					log_file, (char *)conf->stepd_loc,
-					NULL};
-		if (type == LAUNCH_BATCH_JOB) {
-			job_id = ((batch_job_launch_msg_t *)req)->job_id;
-			step_id = ((batch_job_launch_msg_t *)req)->step_id;
-		} else if (type == LAUNCH_TASKS) {
-			job_id = ((launch_tasks_request_msg_t *)req)->job_id;
-			step_id = ((launch_tasks_request_msg_t *)req)->job_step_id;
+		if (rc != SLURM_SUCCESS)
+			error("slurmstepd return code %d", rc);
+
+		cc = SLURM_SUCCESS;
+		cc = write(to_stepd, &cc, sizeof(int));
+		if (cc != sizeof(int)) {
+			error("%s: failed to send ack to stepd %d: %m",
+			      __func__, cc);
 		}
-		snprintf(log_file, sizeof(log_file),
-			 "--log-file=/tmp/slurmstepd_valgrind_%u.%u",
-			 job_id, step_id);
-#else
-		/* no memory checking, default */
-		char *const argv[2] = { (char *)conf->stepd_loc, NULL};
+	}
 #endif
-		int i;
-		int failed = 0;
-		/* inform slurmstepd about our config */
-		setenv("SLURM_CONF", conf->conffile, 1);
+	return rc;
+}
 
-		/*
-		 * Child forks and exits
-		 */
-		if (setsid() < 0) {
-			error("_forkexec_slurmstepd: setsid: %m");
-			failed = 1;
-		}
-		if ((pid = fork()) < 0) {
-			error("_forkexec_slurmstepd: "
-			      "Unable to fork grandchild: %m");
-			failed = 2;
-		} else if (pid > 0) { /* child */
-			exit(0);
-		}
+static void _stepd_pool_ent_free(void *x)
+{
+	stepd_pool_ent_t *ent = (stepd_pool_ent_t *) x;
 
-		/*
-		 * Just in case we (or someone we are linking to)
-		 * opened a file and didn't do a close on exec.  This
-		 * is needed mostly to protect us against libs we link
-		 * to that don't set the flag as we should already be
-		 * setting it for those that we open.  The number 256
-		 * is an arbitrary number based off test7.9.
-		 */
-		for (i=3; i<256; i++) {
-			(void) fcntl(i, F_SETFD, FD_CLOEXEC);
-		}
+	if (ent) {
+		/* The idle slurmstepd reads EOF and exits */
+		(void) close(ent->to_stepd);
+		(void) close(ent->to_slurmd);
+		xfree(ent);
+	}
+}
 
-		/*
-		 * Grandchild exec's the slurmstepd
-		 *
-		 * If the slurmd is being shutdown/restarted before
-		 * the pipe happens the old conf->lfd could be reused
-		 * and if we close it the dup2 below will fail.
-		 */
-		if ((to_stepd[0] != conf->lfd)
-		    && (to_slurmd[1] != conf->lfd))
-			slurm_shutdown_msg_engine(conf->lfd);
-
-		if (close(to_stepd[1]) < 0)
-			error("close write to_stepd in grandchild: %m");
-		if (close(to_slurmd[0]) < 0)
-			error("close read to_slurmd in parent: %m");
-
-		(void) close(STDIN_FILENO); /* ignore return */
-		if (dup2(to_stepd[0], STDIN_FILENO) == -1) {
-			error("dup2 over STDIN_FILENO: %m");
-			exit(1);
-		}
-		fd_set_close_on_exec(to_stepd[0]);
-		(void) close(STDOUT_FILENO); /* ignore return */
-		if (dup2(to_slurmd[1], STDOUT_FILENO) == -1) {
-			error("dup2 over STDOUT_FILENO: %m");
-			exit(1);
-		}
-		fd_set_close_on_exec(to_slurmd[1]);
-		(void) close(STDERR_FILENO); /* ignore return */
-		if (dup2(devnull, STDERR_FILENO) == -1) {
-			error("dup2 /dev/null to STDERR_FILENO: %m");
-			exit(1);
+/* Take an idle slurmstepd from the pool, if there is one */
+static int _stepd_pool_get(int *to_stepd, int *to_slurmd)
+{
+	stepd_pool_ent_t *ent = NULL;
+
+	slurm_mutex_lock(&stepd_pool_mutex);
+	if (stepd_pool_list)
+		ent = list_pop(stepd_pool_list);
+	slurm_mutex_unlock(&stepd_pool_mutex);
+
+	if (!ent)
+		return SLURM_FAILURE;
+
+	*to_stepd = ent->to_stepd;
+	*to_slurmd = ent->to_slurmd;
+	xfree(ent);
+	return SLURM_SUCCESS;
+}
+
+/*
+ * Spawn idle slurmstepds until the pool is back at its configured size.
+ * The lock is not held while forking so launches are not held up.
+ */
+static void *_stepd_pool_fill(void *arg)
+{
+	stepd_pool_ent_t *ent;
+	int to_stepd, to_slurmd;
+
+	slurm_mutex_lock(&stepd_pool_mutex);
+	while (stepd_pool_list &&
+	       (list_count(stepd_pool_list) < stepd_pool_size)) {
+		slurm_mutex_unlock(&stepd_pool_mutex);
+		if (_spawn_slurmstepd(0, NULL, &to_stepd, &to_slurmd) !=
+		    SLURM_SUCCESS) {
+			slurm_mutex_lock(&stepd_pool_mutex);
+			break;
 		}
-		fd_set_noclose_on_exec(STDERR_FILENO);
-		log_fini();
-		if (!failed) {
-			if (conf->chos_loc && !access(conf->chos_loc, X_OK))
-				execvp(conf->chos_loc, argv);
-			else
-				execvp(argv[0], argv);
-			error("exec of slurmstepd failed: %m");
+		fd_set_close_on_exec(to_stepd);
+		fd_set_close_on_exec(to_slurmd);
+		ent = xmalloc(sizeof(stepd_pool_ent_t));
+		ent->to_stepd = to_stepd;
+		ent->to_slurmd = to_slurmd;
+
+		slurm_mutex_lock(&stepd_pool_mutex);
+		if (stepd_pool_list)
+			list_append(stepd_pool_list, ent);
+		else	/* Pool was shut down while we were forking */
+			_stepd_pool_ent_free(ent);
+	}
+	stepd_pool_filling = false;
+	slurm_mutex_unlock(&stepd_pool_mutex);
+
+	return NULL;
+}
+
+/* Replenish the pool in the background, off the step launch path */
+static void _stepd_pool_refill(void)
+{
+	bool start = false;
+
+	slurm_mutex_lock(&stepd_pool_mutex);
+	if (stepd_pool_list && !stepd_pool_filling &&
+	    (list_count(stepd_pool_list) < stepd_pool_size)) {
+		stepd_pool_filling = true;
+		start = true;
+	}
+	slurm_mutex_unlock(&stepd_pool_mutex);
+
+	if (start)
+		slurm_thread_create_detached(NULL, _stepd_pool_fill, NULL);
+}
+
+extern void stepd_pool_reconfig(void)
+{
+	char *launch_params, *tmp_ptr;
+	int size = 0;
+
+#if (SLURMSTEPD_MEMCHECK == 0)
+	launch_params = slurm_get_launch_params();
+	if (launch_params &&
+	    (tmp_ptr = xstrcasestr(launch_params, "slurmstepd_pool="))) {
+		size = atoi(tmp_ptr + 16);
+		if (size < 0) {
+			error("Invalid LaunchParameters slurmstepd_pool: %d",
+			      size);
+			size = 0;
 		}
-		exit(2);
 	}
+	xfree(launch_params);
+#endif
+
+	/*
+	 * Idle slurmstepds were exec'd with the old configuration and
+	 * possibly an old binary, so always start over with fresh ones.
+	 */
+	slurm_mutex_lock(&stepd_pool_mutex);
+	FREE_NULL_LIST(stepd_pool_list);
+	stepd_pool_size = size;
+	if (stepd_pool_size) {
+		stepd_pool_list = list_create(_stepd_pool_ent_free);
+		debug("slurmstepd pool size set to %d", stepd_pool_size);
+	}
+	slurm_mutex_unlock(&stepd_pool_mutex);
+
+	_stepd_pool_refill();
+}
+
+extern void stepd_pool_fini(void)
+{
+	slurm_mutex_lock(&stepd_pool_mutex);
+	FREE_NULL_LIST(stepd_pool_list);
+	stepd_pool_size = 0;
+	slurm_mutex_unlock(&stepd_pool_mutex);
 }
 
+/*
+ * Fork and exec the slurmstepd, then send the slurmstepd its
+ * initialization data.  Then wait for slurmstepd to send an "ok"
+ * message before returning.  When the "ok" message is received,
+ * the slurmstepd has created and begun listening on its unix
+ * domain socket.
+ *
+ * If a pool of idle slurmstepds is configured, one of those is used
+ * instead of forking a new one, and the pool is refilled afterwards.
+ *
+ * Note that this code forks twice and it is the grandchild that
+ * becomes the slurmstepd process, so the slurmstepd's parent process
+ * will be init, not slurmd.
+ */
+static int
+_forkexec_slurmstepd(uint16_t type, void *req,
+		     slurm_addr_t *cli, slurm_addr_t *self,
+		     const hostset_t step_hset, uint16_t protocol_version)
+{
+	int to_stepd = -1, to_slurmd = -1;
+	int rc;
+	bool pooled = false;
+
+	if (_add_starting_step(type, req)) {
+		error("_forkexec_slurmstepd failed in _add_starting_step: %m");
+		return SLURM_FAILURE;
+	}
+
+	if (_stepd_pool_get(&to_stepd, &to_slurmd) == SLURM_SUCCESS)
+		pooled = true;
+	else if (_spawn_slurmstepd(type, req, &to_stepd, &to_slurmd) !=
+		 SLURM_SUCCESS) {
+		_remove_starting_step(type, req);
+		return SLURM_FAILURE;
+	}
+
+	rc = _init_slurmstepd(to_stepd, to_slurmd, type, req, cli, self,
+			      step_hset, protocol_version);
+	if ((rc == -1) && pooled) {
+		/* The idle slurmstepd died, fall back to a new one */
+		debug("pooled slurmstepd unusable, spawning a new one");
+		(void) close(to_stepd);
+		(void) close(to_slurmd);
+		if (_spawn_slurmstepd(type, req, &to_stepd, &to_slurmd) !=
+		    SLURM_SUCCESS) {
+			_remove_starting_step(type, req);
+			return SLURM_FAILURE;
+		}
+		rc = _init_slurmstepd(to_stepd, to_slurmd, type, req, cli,
+				      self, step_hset, protocol_version);
+	}
+	if (rc == -1)
+		rc = SLURM_FAILURE;
+
+	if (_remove_starting_step(type, req))
+		error("Error cleaning up starting_step list");
+
+	if (close(to_stepd) < 0)
+		error("close write to_stepd in parent: %m");
+	if (close(to_slurmd) < 0)
+		error("close read to_slurmd in parent: %m");
+
+	if (pooled)
+		_stepd_pool_refill();
+
+	return rc;
+}
 
 /*
  * The job(step) credential is the only place to get a definitive
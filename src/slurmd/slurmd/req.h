@@ -57,6 +57,16 @@ extern void record_launched_jobs(void);
 void file_bcast_init(void);
 void file_bcast_purge(void);
 
+/*
+ * (Re)build the pool of idle slurmstepd processes used to speed up step
+ * launch, as configured by LaunchParameters=slurmstepd_pool=#. Any idle
+ * slurmstepds left from a previous configuration are retired.
+ */
+extern void stepd_pool_reconfig(void);
+
+/* Retire all idle slurmstepd processes */
+extern void stepd_pool_fini(void);
+
 /*
  * ume_notify - Notify all jobs and steps on this node that a Uncorrectable
  *	Memory Error (UME) has occured by sending SIG_UME (to log event in
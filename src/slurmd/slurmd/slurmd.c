@@ -165,6 +165,11 @@ static int	ncpus;			/* number of CPUs on this node */
 static sig_atomic_t _shutdown = 0;
 static sig_atomic_t _reconfig = 0;
 static pthread_t msg_pthread = (pthread_t) 0;
+static pthread_t node_sampler_pthread = (pthread_t) 0;
+static pthread_mutex_t node_sampler_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t node_sampler_cond = PTHREAD_COND_INITIALIZER;
+static char *node_sampler_file = NULL;
+static uint16_t node_sampler_interval = 0;
 static time_t sent_reg_time = (time_t) 0;
 
 static void      _atfork_final(void);
@@ -186,6 +191,8 @@ static bool      _is_core_spec_cray(void);
 static void      _kill_old_slurmd(void);
 static int       _memory_spec_init(void);
 static void      _msg_engine(void);
+static void     *_node_sampler(void *arg);
+static void      _node_sampler_reconfig(void);
 static uint64_t  _parse_msg_aggr_params(int type, char *params);
 static void      _print_conf(void);
 static void      _print_config(void);
@@ -375,7 +382,10 @@ main (int argc, char **argv)
 
 	msg_aggr_sender_init(conf->hostname, conf->port,
 			     conf->msg_aggr_window_time,
+			     conf->msg_aggr_window_time_max,
 			     conf->msg_aggr_window_msgs);
+	stepd_pool_reconfig();
+	_node_sampler_reconfig();
 	_msg_engine();
 
 	/*
@@ -388,6 +398,13 @@ main (int argc, char **argv)
 		error("Unable to remove pidfile `%s': %m", conf->pidfile);
 
 	_wait_for_all_threads(120);
+	if (node_sampler_pthread) {
+		slurm_mutex_lock(&node_sampler_mutex);
+		slurm_cond_signal(&node_sampler_cond);
+		slurm_mutex_unlock(&node_sampler_mutex);
+		pthread_join(node_sampler_pthread, NULL);
+	}
+	stepd_pool_fini();
 	_slurmd_fini();
 	_destroy_conf();
 	slurm_crypto_fini();	/* must be after _destroy_conf() */
@@ -423,6 +440,81 @@ _registration_engine(void *arg)
 	return NULL;
 }
 
+/*
+ * With JobAcctGatherParams=SharedSampler sample the processes of the node
+ * once per task accounting interval on behalf of all the slurmstepds,
+ * which then only look up the processes of their step in the result.
+ */
+static void *
+_node_sampler(void *arg)
+{
+	char *file_name;
+	time_t last_sample = 0, now;
+	struct timespec ts = {0, 0};
+	uint16_t interval;
+
+	slurm_mutex_lock(&node_sampler_mutex);
+	while (!_shutdown) {
+		interval = node_sampler_interval;
+		now = time(NULL);
+		if (node_sampler_file && interval &&
+		    (interval != (uint16_t) NO_VAL) &&
+		    ((now - last_sample) >= interval)) {
+			file_name = xstrdup(node_sampler_file);
+			slurm_mutex_unlock(&node_sampler_mutex);
+			if (jobacct_gather_sample_node(file_name, interval) !=
+			    SLURM_SUCCESS)
+				debug("Unable to publish node accounting sample");
+			last_sample = now;
+			slurm_mutex_lock(&node_sampler_mutex);
+			/* Reconfigured while sampling, drop what was written */
+			if (xstrcmp(file_name, node_sampler_file))
+				(void) unlink(file_name);
+			xfree(file_name);
+			continue;
+		}
+		/* Woken up early by reconfiguration and shutdown */
+		ts.tv_sec = time(NULL) + 1;
+		slurm_cond_timedwait(&node_sampler_cond, &node_sampler_mutex,
+				     &ts);
+	}
+
+	if (node_sampler_file)
+		(void) unlink(node_sampler_file);
+	xfree(node_sampler_file);
+	slurm_mutex_unlock(&node_sampler_mutex);
+
+	return NULL;
+}
+
+/*
+ * Pick up changes of JobAcctGatherParams=SharedSampler and of the task
+ * accounting interval, starting the sampler thread when first needed.
+ */
+static void
+_node_sampler_reconfig(void)
+{
+	char *file_name = jobacct_gather_node_sample_file(conf->spooldir);
+
+	slurm_mutex_lock(&node_sampler_mutex);
+	node_sampler_interval = conf->acct_freq_task;
+	if (xstrcmp(file_name, node_sampler_file)) {
+		/* Don't let the slurmstepds use a sample no longer updated */
+		if (node_sampler_file)
+			(void) unlink(node_sampler_file);
+		xfree(node_sampler_file);
+		node_sampler_file = file_name;
+		file_name = NULL;
+	}
+	if (node_sampler_file && !node_sampler_pthread) {
+		slurm_thread_create(&node_sampler_pthread, _node_sampler,
+				    NULL);
+	}
+	slurm_cond_signal(&node_sampler_cond);
+	slurm_mutex_unlock(&node_sampler_mutex);
+	xfree(file_name);
+}
+
 static void
 _msg_engine(void)
 {
@@ -1017,7 +1109,10 @@ _reconfigure(void)
 	cpu_freq_reconfig();
 
 	msg_aggr_sender_reconfig(conf->msg_aggr_window_time,
+				 conf->msg_aggr_window_time_max,
 				 conf->msg_aggr_window_msgs);
+	stepd_pool_reconfig();
+	_node_sampler_reconfig();
 
 	/*
 	 * In case the administrator changed the cpu frequency set capabilities
@@ -2008,6 +2103,10 @@ static uint64_t _parse_msg_aggr_params(int type, char *params)
 		if ((sub_str = xstrcasestr(params, "WindowTime=")))
 			value = _get_int(sub_str + 11);
 		break;
+	case WINDOW_TIME_MAX:
+		if ((sub_str = xstrcasestr(params, "WindowTimeMax=")))
+			value = _get_int(sub_str + 14);
+		break;
 	case WINDOW_MSGS:
 		if ((sub_str = xstrcasestr(params, "WindowMsgs=")))
 			value = _get_int(sub_str + 11);
@@ -2024,14 +2123,24 @@ static void _set_msg_aggr_params(void)
 			       conf->msg_aggr_params);
 	conf->msg_aggr_window_msgs = _parse_msg_aggr_params(WINDOW_MSGS,
 			       conf->msg_aggr_params);
+	conf->msg_aggr_window_time_max = _parse_msg_aggr_params(
+			       WINDOW_TIME_MAX, conf->msg_aggr_params);
 
 	if (conf->msg_aggr_window_time == NO_VAL)
 		conf->msg_aggr_window_time = DEFAULT_MSG_AGGR_WINDOW_TIME;
 	if (conf->msg_aggr_window_msgs == NO_VAL)
 		conf->msg_aggr_window_msgs = DEFAULT_MSG_AGGR_WINDOW_MSGS;
+	if ((conf->msg_aggr_window_time_max == NO_VAL) ||
+	    (conf->msg_aggr_window_time_max <= conf->msg_aggr_window_time))
+		conf->msg_aggr_window_time_max = 0;
 	if (conf->msg_aggr_window_msgs > 1) {
 		info("Message aggregation enabled: WindowMsgs=%"PRIu64", WindowTime=%"PRIu64,
 		     conf->msg_aggr_window_msgs, conf->msg_aggr_window_time);
+		if (conf->msg_aggr_window_time_max) {
+			info("Message aggregation window adapts up to "
+			     "WindowTimeMax=%"PRIu64,
+			     conf->msg_aggr_window_time_max);
+		}
 	} else
 		info("Message aggregation disabled");
 }
@@ -60,6 +60,7 @@ extern int devnull;
  */
 typedef enum {
 	WINDOW_TIME,
+	WINDOW_TIME_MAX,
 	WINDOW_MSGS
 } msg_aggr_param_type_t;
 
@@ -154,6 +155,8 @@ typedef struct slurmd_config {
 	char           *msg_aggr_params;      /* message aggregation params */
 	uint64_t        msg_aggr_window_msgs; /* msg aggr window size in msgs */
 	uint64_t        msg_aggr_window_time; /* msg aggr window size in time */
+	uint64_t        msg_aggr_window_time_max; /* adaptive msg aggr window
+						   * upper bound in time */
 	uint16_t	use_pam;
 	uint32_t	task_plugin_param; /* TaskPluginParams, expressed
 					 * using cpu_bind_type_t flags */
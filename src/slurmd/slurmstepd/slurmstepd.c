@@ -123,6 +123,10 @@ main (int argc, char **argv)
 	_init_from_slurmd(STDIN_FILENO, argv, &cli, &self, &msg,
 			  &ngids, &gids);
 
+	/* Use the node wide accounting samples published by the slurmd */
+	jobacct_gather_set_node_sample_file(
+		jobacct_gather_node_sample_file(conf->spooldir));
+
 	/* Create the stepd_step_rec_t, mostly from info in a
 	 * launch_tasks_request_msg_t or a batch_job_launch_msg_t */
 	if (!(job = _step_setup(cli, self, msg))) {
@@ -456,8 +460,13 @@ _init_from_slurmd(int sock, char **argv,
 
 	log_init(argv[0], lopts, LOG_DAEMON, NULL);
 
-	/* receive job type from slurmd */
-	safe_read(sock, &step_type, sizeof(int));
+	/* receive job type from slurmd. A slurmstepd waiting in slurmd's
+	 * pool gets EOF here if it is retired without being used. */
+	len = read(sock, &step_type, sizeof(int));
+	if (len == 0)
+		exit(0);
+	if (len != sizeof(int))
+		goto rwfail;
 	debug3("step_type = %d", step_type);
 
 	/* receive reverse-tree info from slurmd */
@@ -64,6 +64,7 @@
 #define OPT_LONG_LOCAL        0x106
 #define OPT_LONG_SIBLING      0x107
 #define OPT_LONG_FEDR         0x108
+#define OPT_LONG_REPLICA      0x109
 
 /* FUNCTIONS */
 static List  _build_job_list( char* str );
@@ -120,6 +121,7 @@ parse_command_line( int argc, char* *argv )
 		{"partitions", required_argument, 0, 'p'},
 		{"priority",   no_argument,       0, 'P'},
 		{"qos",        required_argument, 0, 'q'},
+		{"replica",    no_argument,       0, OPT_LONG_REPLICA},
 		{"reservation",required_argument, 0, 'R'},
 		{"sib",        no_argument,       0, OPT_LONG_SIBLING},
 		{"sibling",    no_argument,       0, OPT_LONG_SIBLING},
@@ -163,6 +165,8 @@ parse_command_line( int argc, char* *argv )
 		params.local_flag = true;
 	if (getenv("SQUEUE_PRIORITY"))
 		params.priority_flag = true;
+	if (getenv("SQUEUE_REPLICA"))
+		params.replica_flag = true;
 	if (getenv("SQUEUE_SIB") || getenv("SQUEUE_SIBLING"))
 		params.sibling_flag = true;
 	while ((opt_char = getopt_long(argc, argv,
@@ -330,6 +334,9 @@ parse_command_line( int argc, char* *argv )
 		case OPT_LONG_LOCAL:
 			params.local_flag = true;
 			break;
+		case OPT_LONG_REPLICA:
+			params.replica_flag = true;
+			break;
 		case OPT_LONG_SIBLING:
 			params.sibling_flag = true;
 			break;
@@ -478,7 +485,9 @@ parse_command_line( int argc, char* *argv )
 		params.job_id = *job_id_ptr;
 		list_iterator_destroy(iterator);
 	}
-	if (params.user_list && (list_count(params.user_list) == 1)) {
+	/* A single user's jobs are filtered here, not read from a replica */
+	if (params.user_list && (list_count(params.user_list) == 1) &&
+	    !params.replica_flag) {
 		ListIterator iterator;
 		uint32_t *uid_ptr;
 		iterator = list_iterator_create(params.user_list);
@@ -1727,6 +1736,7 @@ _print_options(void)
 	printf( "nodes       = %s\n", hostlist ) ;
 	printf( "partitions  = %s\n", params.partitions ) ;
 	printf( "priority    = %s\n", params.priority_flag ? "true" : "false");
+	printf( "replica     = %s\n", params.replica_flag ? "true" : "false");
 	printf( "reservation = %s\n", params.reservation ) ;
 	printf( "sibling      = %s\n", params.sibling_flag ? "true" : "false");
 	printf( "sort        = %s\n", params.sort ) ;
@@ -2045,7 +2055,7 @@ Usage: squeue [-A account] [--clusters names] [-i seconds] [--job jobid]\n\
               [--reservation reservation] [--sort fields] [--start]\n\
               [--step step_id] [-t states] [-u user_name] [--usage]\n\
               [-L licenses] [-w nodes] [--federation] [--local] [--sibling]\n\
-	      [-ahjlrsv]\n");
+              [--replica] [-ahjlrsv]\n");
 }
 
 static void _help(void)
@@ -2082,6 +2092,9 @@ Usage: squeue [OPTIONS]\n\
 				  to view, default is all qos's\n\
   -R, --reservation=name          reservation to view, default is all\n\
   -r, --array                     display one job array element per line\n\
+      --replica                   with --all, accept job information from the\n\
+                                  backup controller's replica of the primary\n\
+                                  controller's state when it is available\n\
       --sibling                   Report information about all sibling jobs\n\
                                   on a federated cluster. Implies --federation.\n\
   -s, --step=step(s)              comma separated list of job steps\n\
@@ -61,6 +61,8 @@ int max_line_size;
 /*************
  * Functions *
  *************/
+static void _build_job_filter(job_info_filter_t *filter);
+static void _free_job_filter(job_info_filter_t *filter);
 static int  _get_info(bool clear_old);
 static int  _get_window_width( void );
 static void _print_date( void );
@@ -163,12 +165,76 @@ _get_window_width( void )
 }
 
 
+/* Copy a list of uint32_t pointers into an array */
+static uint32_t *_uint32_list_array(List uint32_list, uint32_t *cnt)
+{
+	ListIterator iter;
+	uint32_t *array, *uint32_ptr;
+
+	*cnt = list_count(uint32_list);
+	array = xmalloc(sizeof(uint32_t) * (*cnt));
+	*cnt = 0;
+	iter = list_iterator_create(uint32_list);
+	while ((uint32_ptr = list_next(iter)))
+		array[(*cnt)++] = *uint32_ptr;
+	list_iterator_destroy(iter);
+
+	return array;
+}
+
+/* Join a list of strings into a comma separated string */
+static char *_str_list_join(List str_list)
+{
+	ListIterator iter;
+	char *str, *joined = NULL;
+
+	iter = list_iterator_create(str_list);
+	while ((str = list_next(iter)))
+		xstrfmtcat(joined, "%s%s", joined ? "," : "", str);
+	list_iterator_destroy(iter);
+
+	return joined;
+}
+
+/*
+ * Have slurmctld drop jobs which _filter_job() would reject by user, account,
+ * partition or state. Jobs returned are still run through _filter_job().
+ * A replica holds all jobs, so no filter is sent with --replica.
+ */
+static void _build_job_filter(job_info_filter_t *filter)
+{
+	memset(filter, 0, sizeof(job_info_filter_t));
+	if (params.replica_flag)
+		return;
+	if (params.account_list && list_count(params.account_list))
+		filter->accounts = _str_list_join(params.account_list);
+	if (params.part_list && list_count(params.part_list))
+		filter->partitions = _str_list_join(params.part_list);
+	if (params.state_list && list_count(params.state_list)) {
+		filter->states = _uint32_list_array(params.state_list,
+						    &filter->state_cnt);
+	}
+	if (params.user_list && list_count(params.user_list)) {
+		filter->user_ids = _uint32_list_array(params.user_list,
+						      &filter->user_cnt);
+	}
+}
+
+static void _free_job_filter(job_info_filter_t *filter)
+{
+	xfree(filter->accounts);
+	xfree(filter->partitions);
+	xfree(filter->states);
+	xfree(filter->user_ids);
+}
+
 /* _print_job - print the specified job's information */
 static int
 _print_job ( bool clear_old )
 {
 	static job_info_msg_t *old_job_ptr;
 	job_info_msg_t *new_job_ptr = NULL;
+	job_info_filter_t filter;
 	int error_code;
 	uint16_t show_flags = 0;
 
@@ -180,6 +246,8 @@ _print_job ( bool clear_old )
 		show_flags |= SHOW_LOCAL;
 	if (params.sibling_flag)
 		show_flags |= SHOW_FEDERATION | SHOW_SIBLING;
+	if (params.replica_flag)
+		show_flags |= SHOW_REPLICA;
 
 	/* We require detail data when CPUs are requested */
 	if (params.format && strstr(params.format, "C"))
@@ -199,9 +267,11 @@ _print_job ( bool clear_old )
 		} else {
 			if (params.clusters)
 				show_flags |= SHOW_LOCAL;
-			error_code = slurm_load_jobs(
+			_build_job_filter(&filter);
+			error_code = slurm_load_jobs_filter(
 				old_job_ptr->last_update,
-				&new_job_ptr, show_flags);
+				&new_job_ptr, show_flags, &filter);
+			_free_job_filter(&filter);
 		}
 		if (error_code ==  SLURM_SUCCESS)
 			slurm_free_job_info_msg( old_job_ptr );
@@ -216,8 +286,11 @@ _print_job ( bool clear_old )
 		error_code = slurm_load_job_user(&new_job_ptr, params.user_id,
 						 show_flags);
 	} else {
-		error_code = slurm_load_jobs((time_t) NULL, &new_job_ptr,
-					     show_flags);
+		_build_job_filter(&filter);
+		error_code = slurm_load_jobs_filter((time_t) NULL,
+						    &new_job_ptr, show_flags,
+						    &filter);
+		_free_job_filter(&filter);
 	}
 
 	if (error_code) {
@@ -79,6 +79,7 @@ struct squeue_parameters {
 	bool long_list;
 	bool no_header;
 	bool priority_flag;
+	bool replica_flag;
 	int  verbose;
 
 	char* accounts;
@@ -0,0 +1,113 @@
+/* Test of the reverse job dependency graph in src/slurmctld/depend_graph.c
+ */
+#include <stdlib.h>
+#include <testsuite/dejagnu.h>
+
+#include "src/common/xmalloc.h"
+
+/* The graph is part of slurmctld rather than libslurm */
+#include "src/slurmctld/depend_graph.c"
+
+#define PASSES		1000
+#define MANY_JOBS	5000
+
+#define TEST(_tst, _msg) do {		\
+	if (! (_tst))			\
+		fail( _msg );		\
+	else				\
+		pass( _msg );		\
+} while (0)
+
+/* IDs passed to _record() by depend_graph_pop() */
+typedef struct {
+	uint32_t *ids;
+	uint32_t cnt;
+	uint32_t size;
+} popped_t;
+
+static void _record(uint32_t dep_job_id, void *arg)
+{
+	popped_t *popped = (popped_t *) arg;
+
+	if (popped->cnt >= popped->size) {
+		popped->size = MAX(popped->size * 2, 8);
+		xrealloc(popped->ids, sizeof(uint32_t) * popped->size);
+	}
+	popped->ids[popped->cnt++] = dep_job_id;
+}
+
+/* Test if dep_job_id was popped exactly once */
+static bool _popped_once(popped_t *popped, uint32_t dep_job_id)
+{
+	uint32_t i, cnt = 0;
+
+	for (i = 0; i < popped->cnt; i++) {
+		if (popped->ids[i] == dep_job_id)
+			cnt++;
+	}
+	return (cnt == 1);
+}
+
+int
+main(int argc, char *argv[])
+{
+	popped_t popped = { NULL, 0, 0 };
+	uint32_t i;
+
+	note("Testing repeated dependency tests");
+	{
+		/* Job 100 depends upon jobs 10 and 11, job 101 depends upon
+		 * job 10 (twice) and is tested again on every pass, as jobs
+		 * with a singleton dependency are */
+		for (i = 0; i < PASSES; i++) {
+			depend_graph_add(10, 100);
+			depend_graph_add(11, 100);
+			depend_graph_add(10, 101);
+			depend_graph_add(10, 101);
+		}
+		TEST(depend_graph_pop(10, _record, &popped) == 2,
+		     "repeated pop count");
+		TEST(_popped_once(&popped, 100) && _popped_once(&popped, 101),
+		     "repeated pop IDs");
+
+		/* Job 11 has not changed state, job 100 is still recorded */
+		popped.cnt = 0;
+		depend_graph_add(10, 100);
+		TEST(depend_graph_pop(11, _record, &popped) == 1,
+		     "other dependency pop count");
+		TEST(_popped_once(&popped, 100), "other dependency pop ID");
+
+		popped.cnt = 0;
+		TEST(depend_graph_pop(10, _record, &popped) == 1,
+		     "registered again pop count");
+		TEST(depend_graph_pop(10, _record, &popped) == 0,
+		     "second pop count");
+		TEST(depend_graph_pop(12, _record, &popped) == 0,
+		     "unknown job pop count");
+	}
+
+	note("Testing many dependent jobs");
+	{
+		popped.cnt = 0;
+		for (i = 0; i < PASSES * 2; i++) {
+			/* Interleaved and in decreasing order */
+			depend_graph_add(20,
+					 1000 + MANY_JOBS - (i % MANY_JOBS));
+			depend_graph_add(21, 1000 + i);
+		}
+		for (i = 0; i < MANY_JOBS; i++)
+			depend_graph_add(20, 1000 + MANY_JOBS - i);
+		TEST(depend_graph_pop(20, _record, &popped) == MANY_JOBS,
+		     "many pop count");
+		for (i = 1; i < popped.cnt; i++) {
+			if (popped.ids[i - 1] >= popped.ids[i])
+				break;
+		}
+		TEST(i == popped.cnt, "many pop IDs unique");
+	}
+
+	depend_graph_fini();
+	xfree(popped.ids);
+	totals();
+	return failed;
+}
@@ -0,0 +1,177 @@
+/* Test of node name to bitmap conversion in src/common/node_conf.c,
+ * compared with and timed against conversion through a hostlist.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include "src/common/bitstring.h"
+#include "src/common/hostlist.h"
+#include "src/common/node_conf.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+#define DEV_NODES	1000
+#define TOTAL_NODES	50000
+#define ITERATIONS	20
+
+/* testsuite/dejagnu.h conflicts with <sys/wait.h> from node_conf.h */
+static int failed = 0;
+
+#define TEST(_tst, _msg) do {			\
+	if (! (_tst)) {				\
+		printf("FAIL: %s\n", _msg);	\
+		failed++;			\
+	} else					\
+		printf("PASS: %s\n", _msg);	\
+} while (0)
+
+static long _usec(struct timeval *tv1, struct timeval *tv2)
+{
+	return ((tv2->tv_sec - tv1->tv_sec) * 1000000) +
+	       (tv2->tv_usec - tv1->tv_usec);
+}
+
+/* Build a table of dev000-dev999 and node00000-node48999 */
+static void _build_node_table(void)
+{
+	int i;
+
+	node_record_table_ptr = xmalloc(sizeof(struct node_record) *
+					TOTAL_NODES);
+	for (i = 0; i < TOTAL_NODES; i++) {
+		if (i < DEV_NODES) {
+			node_record_table_ptr[i].name =
+				xstrdup_printf("dev%03d", i);
+		} else {
+			node_record_table_ptr[i].name =
+				xstrdup_printf("node%05d", i - DEV_NODES);
+		}
+		node_record_table_ptr[i].magic = NODE_MAGIC;
+	}
+	node_record_count = TOTAL_NODES;
+	rehash_node();
+}
+
+/* Build the node name index outside of the timed loops */
+static void _warm_up(void)
+{
+	bitstr_t *bitmap = NULL;
+
+	node_name2bitmap("dev000", false, &bitmap);
+	FREE_NULL_BITMAP(bitmap);
+}
+
+/* Convert bitmap both ways, compare with hostlist conversion and time it */
+static void _test_bitmap(bitstr_t *bitmap, char *desc)
+{
+	struct timeval tv1, tv2, tv3;
+	bitstr_t *bitmap2 = NULL, *bitmap3 = NULL;
+	char *names = NULL, *names2;
+	hostlist_t hl;
+	int i;
+
+	gettimeofday(&tv1, NULL);
+	for (i = 0; i < ITERATIONS; i++) {
+		xfree(names);
+		names = bitmap2node_name(bitmap);
+		FREE_NULL_BITMAP(bitmap2);
+		node_name2bitmap(names, false, &bitmap2);
+	}
+	gettimeofday(&tv2, NULL);
+	for (i = 0; i < ITERATIONS; i++) {
+		hl = bitmap2hostlist(bitmap);
+		if (hl)
+			hostlist_sort(hl);
+		if (hl) {
+			names2 = hostlist_ranged_string_xmalloc(hl);
+			hostlist_destroy(hl);
+		} else
+			names2 = xstrdup("");
+		hl = hostlist_create(names2);
+		hostlist2bitmap(hl, false, &bitmap3);
+		hostlist_destroy(hl);
+		if (i < (ITERATIONS - 1))
+			xfree(names2);
+	}
+	gettimeofday(&tv3, NULL);
+
+	TEST(!xstrcmp(names, names2), desc);
+	TEST(bit_equal(bitmap, bitmap2), desc);
+	TEST(bit_equal(bitmap, bitmap3), desc);
+	printf("%s: node_conf %ld usec, hostlist %ld usec\n", desc,
+	       _usec(&tv1, &tv2) / ITERATIONS,
+	       _usec(&tv2, &tv3) / ITERATIONS);
+
+	xfree(names);
+	xfree(names2);
+	FREE_NULL_BITMAP(bitmap2);
+	FREE_NULL_BITMAP(bitmap3);
+}
+
+int
+main(int argc, char *argv[])
+{
+	bitstr_t *bitmap = NULL;
+	int i;
+
+	_build_node_table();
+	_warm_up();
+
+	printf("Testing node name conversion of %d nodes\n", TOTAL_NODES);
+	{
+		bitmap = bit_alloc(TOTAL_NODES);
+		_test_bitmap(bitmap, "no nodes");
+
+		bit_set(bitmap, 7);
+		_test_bitmap(bitmap, "one node");
+
+		bit_nset(bitmap, 0, TOTAL_NODES - 1);
+		_test_bitmap(bitmap, "all nodes");
+
+		bit_nclear(bitmap, 0, TOTAL_NODES - 1);
+		for (i = 0; i < TOTAL_NODES; i += 2)
+			bit_set(bitmap, i);
+		_test_bitmap(bitmap, "every other node");
+
+		bit_nclear(bitmap, 0, TOTAL_NODES - 1);
+		srand(1);
+		for (i = 0; i < TOTAL_NODES; i++) {
+			if ((rand() % 10) == 0)
+				bit_set(bitmap, i);
+		}
+		_test_bitmap(bitmap, "random nodes");
+
+		bit_nclear(bitmap, 0, TOTAL_NODES - 1);
+		for (i = 0; i < TOTAL_NODES; i += 1000)
+			bit_nset(bitmap, i + 10, i + 900);
+		bit_set(bitmap, DEV_NODES - 1);
+		_test_bitmap(bitmap, "node blocks");
+	}
+
+	printf("Testing node name expressions\n");
+	{
+		bitstr_t *bitmap2 = NULL;
+
+		TEST(node_name2bitmap("dev[001-003],node00005", false,
+				      &bitmap2) == SLURM_SUCCESS,
+		     "valid expression");
+		TEST((bit_set_count(bitmap2) == 4) &&
+		     bit_test(bitmap2, 1) && bit_test(bitmap2, 3) &&
+		     bit_test(bitmap2, DEV_NODES + 5),
+		     "valid expression bitmap");
+		FREE_NULL_BITMAP(bitmap2);
+
+		TEST(node_name2bitmap("dev[998-1000]", false, &bitmap2) ==
+		     EINVAL, "missing node");
+		FREE_NULL_BITMAP(bitmap2);
+
+		TEST(node_name2bitmap("dev[1-3]", false, &bitmap2) ==
+		     EINVAL, "other width");
+		TEST(bit_set_count(bitmap2) == 0, "other width bitmap");
+		FREE_NULL_BITMAP(bitmap2);
+	}
+
+	FREE_NULL_BITMAP(bitmap);
+	return failed;
+}